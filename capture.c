@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include "capture.h"
+
+int capture_open(Capture *cap, const char *filename) {
+    memset(cap, 0, sizeof(*cap));
+
+    cap->file = fopen(filename, "ab");
+    if (!cap->file) {
+        perror("Erro ao abrir arquivo de captura");
+        return -1;
+    }
+
+    cap->buffer = malloc(CAPTURE_BUF_SIZE);
+    if (cap->buffer) {
+        setvbuf(cap->file, cap->buffer, _IOFBF, CAPTURE_BUF_SIZE);
+    }
+
+    // arquivo novo ==> grava o cabecalho; existente ==> apenas anexa registros
+    fseek(cap->file, 0, SEEK_END);
+    if (ftell(cap->file) == 0) {
+        capture_file_header_t header;
+        memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = htons(CAPTURE_VERSION);
+        header.reserved = 0;
+        fwrite(&header, sizeof(header), 1, cap->file);
+    }
+
+    gettimeofday(&cap->last_flush, NULL);
+    capture_write(cap, CAPTURE_SESSION, NULL, NULL, 0);
+    cap->records = 0;
+    return 0;
+}
+
+int capture_write(Capture *cap, int direction, const struct sockaddr *addr,
+                  const void *data, uint16_t len) {
+    if (!cap || !cap->file) return -1;
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    capture_record_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.ts_sec = htonl((uint32_t)now.tv_sec);
+    rec.ts_usec = htonl((uint32_t)now.tv_usec);
+    rec.direction = (uint8_t)direction;
+    rec.length = htons(len);
+
+    if (addr && addr->sa_family == AF_INET) {
+        const struct sockaddr_in *in4 = (const struct sockaddr_in *)addr;
+        rec.family = 4;
+        rec.port = in4->sin_port;
+        memcpy(rec.addr, &in4->sin_addr, sizeof(in4->sin_addr));
+    } else if (addr && addr->sa_family == AF_INET6) {
+        const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *)addr;
+        rec.family = 6;
+        rec.port = in6->sin6_port;
+        memcpy(rec.addr, &in6->sin6_addr, sizeof(in6->sin6_addr));
+    }
+
+    if (fwrite(&rec, sizeof(rec), 1, cap->file) != 1 ||
+        (len > 0 && fwrite(data, 1, len, cap->file) != len)) {
+        return -1;
+    }
+    cap->records++;
+
+    // o buffer do stdio absorve as escritas; descarrega no maximo uma vez por intervalo
+    long elapsed = (now.tv_sec - cap->last_flush.tv_sec) * 1000000L +
+                   (now.tv_usec - cap->last_flush.tv_usec);
+    if (elapsed >= CAPTURE_FLUSH_USEC) {
+        fflush(cap->file);
+        cap->last_flush = now;
+    }
+    return 0;
+}
+
+void capture_close(Capture *cap) {
+    if (cap->file) {
+        fclose(cap->file);
+        cap->file = NULL;
+    }
+    free(cap->buffer);
+    cap->buffer = NULL;
+}
+
+int capture_open_read(Capture *cap, const char *filename) {
+    memset(cap, 0, sizeof(*cap));
+
+    cap->file = fopen(filename, "rb");
+    if (!cap->file) {
+        perror("Erro ao abrir arquivo de captura");
+        return -1;
+    }
+
+    cap->buffer = malloc(CAPTURE_BUF_SIZE);
+    if (cap->buffer) {
+        setvbuf(cap->file, cap->buffer, _IOFBF, CAPTURE_BUF_SIZE);
+    }
+
+    capture_file_header_t header;
+    if (fread(&header, sizeof(header), 1, cap->file) != 1 ||
+        memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "Erro: '%s' nao e um arquivo de captura valido\n", filename);
+        capture_close(cap);
+        return -1;
+    }
+    if (ntohs(header.version) != CAPTURE_VERSION) {
+        fprintf(stderr, "Erro: versao de captura %d nao suportada\n", ntohs(header.version));
+        capture_close(cap);
+        return -1;
+    }
+    return 0;
+}
+
+int capture_next(Capture *cap, capture_record_t *rec, void *data, size_t data_size) {
+    if (fread(rec, sizeof(*rec), 1, cap->file) != 1) return 0;
+
+    rec->ts_sec = ntohl(rec->ts_sec);
+    rec->ts_usec = ntohl(rec->ts_usec);
+    rec->port = ntohs(rec->port);
+    rec->length = ntohs(rec->length);
+
+    if (rec->length > data_size) return -1;
+    if (fread(data, 1, rec->length, cap->file) != rec->length) return -1;
+
+    cap->records++;
+    return 1;
+}
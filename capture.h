@@ -0,0 +1,58 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+// Formato do arquivo de captura (todos os campos em ordem de rede):
+//   cabecalho do arquivo: magic "PADC", versao, reservado
+//   registros: capture_record_t seguido de 'length' bytes do datagrama
+// Cada execucao do servidor anexa ao arquivo um registro CAPTURE_SESSION
+// (sem dados) antes dos seus datagramas; o replay reproduz uma sessao por vez.
+#define CAPTURE_MAGIC "PADC"
+#define CAPTURE_VERSION 1
+#define CAPTURE_BUF_SIZE (64 * 1024)
+#define CAPTURE_FLUSH_USEC 1000000
+
+#define CAPTURE_RX 0 // datagrama recebido pelo servidor
+#define CAPTURE_TX 1 // datagrama enviado pelo servidor
+#define CAPTURE_SESSION 2 // inicio de uma execucao do servidor
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+} capture_file_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint8_t direction;
+    uint8_t family; // 4 ou 6
+    uint16_t port;
+    uint8_t addr[16];
+    uint16_t length;
+} capture_record_t;
+
+typedef struct {
+    FILE *file;
+    char *buffer;
+    struct timeval last_flush;
+    unsigned long records;
+} Capture;
+
+// Abre (ou cria) o arquivo em modo append e marca o inicio de uma nova sessao.
+// Retorna -1 em caso de erro.
+int capture_open(Capture *cap, const char *filename);
+int capture_write(Capture *cap, int direction, const struct sockaddr *addr,
+                  const void *data, uint16_t len);
+void capture_close(Capture *cap);
+
+// Leitura sequencial: capture_next preenche 'rec' em ordem de host e
+// retorna 1 se leu um registro, 0 no fim do arquivo e -1 se corrompido.
+int capture_open_read(Capture *cap, const char *filename);
+int capture_next(Capture *cap, capture_record_t *rec, void *data, size_t data_size);
+
+#endif // CAPTURE_H
@@ -19,6 +19,22 @@ int current_status[MAX_NODES];
 pthread_mutex_t status_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 
+// Cadencia adaptativa: novo alerta ==> relatorio antecipado e o intervalo volta
+// a TELEMETRY_MIN_SEC (o antigo periodo fixo); sem alerta novo ==> dobra ate
+// TELEMETRY_MAX_SEC. Dois relatorios nunca ficam a menos de TELEMETRY_MIN_SEC:
+// alertas que surgem dentro dessa janela sao acumulados em alert_window e vao
+// juntos no proximo datagrama. Equipe liberada no status da frota com alerta
+// ainda sem equipe ==> relatorio antecipado, sem mexer no intervalo.
+#define MONITORING_INTERVAL_SEC 5
+#define TELEMETRY_MIN_SEC 30
+#define TELEMETRY_MAX_SEC 120
+
+pthread_cond_t cond_status_alert = PTHREAD_COND_INITIALIZER;
+int new_alert_pending = 0;
+int alert_window[MAX_NODES]; // cidades em alerta desde o ultimo relatorio
+int fleet_team_freed = 0; // equipe liberada no status da frota (protegido por status_mutex)
+
+
 int sockfd;
 struct sockaddr_storage server_addr;
 socklen_t server_addr_len;
@@ -34,9 +50,11 @@ typedef struct {
     int city_id;
     int team_id;
     int active; 
+    int route[MAX_NODES]; // capital da equipe -> ... -> cidade (vazia em ordens sem rota)
+    int route_len;
 } Mission;
 
-Mission current_mission = { -1, -1, 0 };
+Mission current_mission = { -1, -1, 0, {0}, 0 };
 pthread_cond_t cond_mission_start = PTHREAD_COND_INITIALIZER;
 pthread_mutex_t mutex_mission = PTHREAD_MUTEX_INITIALIZER;
 
@@ -46,6 +64,13 @@ pthread_mutex_t mutex_conclusao_ack = PTHREAD_MUTEX_INITIALIZER;
 int conclusao_ack_received = 0;
 
 
+// Estado da frota publicado pelo servidor via multicast
+int mcast_fd = -1;
+uint32_t fleet_free_mask[MAX_SHARDS][STATUS_MASK_WORDS];
+int fleet_seen[MAX_SHARDS];
+pthread_mutex_t mutex_fleet = PTHREAD_MUTEX_INITIALIZER;
+
+
 
 
 void send_udp_packet(void *buffer, size_t len) {
@@ -61,32 +86,95 @@ void *thread_monitoring(void *_arg) {
 
     while (1) {
         
-        sleep(5); 
+        sleep(MONITORING_INTERVAL_SEC); 
 
         pthread_mutex_lock(&status_mutex);
         
-        int alerts = 0;
+        int new_alerts = 0;
         for (int i = 0; i < amazonia_map.num_nodes; i++) {
             
             if ((rand() % 100) < 3) {
+                if (current_status[i] == 0) new_alerts++;
                 current_status[i] = 1;
-                alerts++;
+                alert_window[i] = 1;
             } else {
                 current_status[i] = 0; 
             }
         }
+
+        // so a passagem para alerta acorda a telemetria antes do prazo
+        if (new_alerts > 0) {
+            new_alert_pending = 1;
+            pthread_cond_signal(&cond_status_alert);
+        }
         pthread_mutex_unlock(&status_mutex);
     }
     return NULL;
 }
 
+// Alguma cidade em alerta sem a missao local? (chamar com status_mutex)
+int alert_waiting(void) {
+    pthread_mutex_lock(&mutex_mission);
+    int waiting = 0;
+    for (int i = 0; i < amazonia_map.num_nodes && !waiting; i++) {
+        if (current_status[i] == 1 && !(current_mission.active && current_mission.city_id == i)) {
+            waiting = 1;
+        }
+    }
+    pthread_mutex_unlock(&mutex_mission);
+    return waiting;
+}
+
+struct timespec seconds_after(const struct timeval *from, int sec) {
+    struct timespec ts = { from->tv_sec + sec, from->tv_usec * 1000 };
+    return ts;
+}
+
 void *thread_telemetry(void *arg) {
     printf("[Thread Telemetria] Iniciada\n");
 
+    int interval = TELEMETRY_MIN_SEC;
+    struct timeval last_sent;
+    gettimeofday(&last_sent, NULL);
+    last_sent.tv_sec -= TELEMETRY_MIN_SEC; // o primeiro alerta sai sem esperar
+
     while (1) {
-        sleep(30); 
+        pthread_mutex_lock(&status_mutex);
+        struct timespec deadline = seconds_after(&last_sent, interval);
+
+        // alerta novo (ou equipe liberada com alerta esperando) antecipa o prazo,
+        // mas so ate TELEMETRY_MIN_SEC apos o ultimo envio; ate la os alertas acumulam
+        int urgent = 0, retry = 0;
+        while (1) {
+            if (new_alert_pending) urgent = 1;
+            if (fleet_team_freed) {
+                fleet_team_freed = 0;
+                if (alert_waiting()) retry = 1;
+            }
+            if (urgent || retry) {
+                struct timespec earliest = seconds_after(&last_sent, TELEMETRY_MIN_SEC);
+                if (earliest.tv_sec < deadline.tv_sec ||
+                    (earliest.tv_sec == deadline.tv_sec && earliest.tv_nsec < deadline.tv_nsec)) {
+                    deadline = earliest;
+                }
+            }
+            if (pthread_cond_timedwait(&cond_status_alert, &status_mutex, &deadline) != 0) {
+                break;
+            }
+        }
+        new_alert_pending = 0;
+        fleet_team_freed = 0;
+        gettimeofday(&last_sent, NULL);
+        pthread_mutex_unlock(&status_mutex);
+
+        if (urgent) {
+            interval = TELEMETRY_MIN_SEC;
+        } else if (!retry) {
+            interval = (interval * 2 > TELEMETRY_MAX_SEC) ? TELEMETRY_MAX_SEC : interval * 2;
+        }
 
-        printf("\n[ENVIANDO TELEMETRIA]\n");
+        printf("\n[ENVIANDO TELEMETRIA]%s Proximo relatorio em ate %d s\n",
+               urgent ? " Novo alerta." : (retry ? " Equipe liberada." : ""), interval);
 
         header_t header;
         payload_telemetria_t payload;
@@ -99,9 +187,11 @@ void *thread_telemetry(void *arg) {
         
         
         for (int i = 0; i < amazonia_map.num_nodes; i++) {
+            int status = current_status[i] || alert_window[i];
             payload.dados[i].id_cidade = htonl(amazonia_map.nodes[i].id);
-            payload.dados[i].status = htonl(current_status[i]);
-            if (current_status[i] == 1) {
+            payload.dados[i].status = htonl(status);
+            alert_window[i] = 0;
+            if (status == 1) {
                 printf("ALERTA: %s (ID=%d)\n", amazonia_map.nodes[i].name, i);
             }
         }
@@ -173,6 +263,13 @@ void *thread_drone_sim(void *_arg) {
         printf("Equipe %s atuando em %s\n", 
                amazonia_map.nodes[my_mission.team_id].name, 
                amazonia_map.nodes[my_mission.city_id].name);
+        if (my_mission.route_len > 0) {
+            printf("Rota:");
+            for (int i = 0; i < my_mission.route_len; i++) {
+                printf("%s %s", i > 0 ? " ->" : "", amazonia_map.nodes[my_mission.route[i]].name);
+            }
+            printf("\n");
+        }
         
         
         int duration = (rand() % 30) + 1; 
@@ -214,6 +311,46 @@ void *thread_drone_sim(void *_arg) {
 }
 
 
+// Ordem de despacho (com ou sem rota): confirma ao servidor e registra a missao.
+void handle_order(int city_id, int team_id, const int *route, int route_len) {
+    printf("\n[ORDEM DE DRONE RECEBIDA]\n");
+    printf("Cidade: %s (ID=%d)\n", amazonia_map.nodes[city_id].name, city_id);
+    printf("Equipe: %s (ID=%d)\n", amazonia_map.nodes[team_id].name, team_id);
+    if (route_len > 0) printf("Rota com %d cidades\n", route_len);
+
+    
+    header_t ack_hdr;
+    payload_ack_t ack_pl;
+    ack_hdr.type = htons(MSG_ACK);
+    ack_hdr.length = htons(sizeof(payload_ack_t));
+    ack_pl.status = htonl(ACK_EQUIPE_DRONE);
+    
+    char ack_buf[sizeof(header_t) + sizeof(payload_ack_t)];
+    memcpy(ack_buf, &ack_hdr, sizeof(header_t));
+    memcpy(ack_buf + sizeof(header_t), &ack_pl, sizeof(payload_ack_t));
+    
+    send_udp_packet(ack_buf, sizeof(ack_buf));
+    printf("ACK enviado ao servidor\n");
+
+    
+    pthread_mutex_lock(&mutex_mission);
+    if (current_mission.active) {
+        
+        
+        printf("AVISO: Ja existe missao ativa localmente, nova ordem ignorada.\n");
+    } else {
+        current_mission.city_id = city_id;
+        current_mission.team_id = team_id;
+        current_mission.active = 1;
+        current_mission.route_len = route_len;
+        if (route_len > 0) memcpy(current_mission.route, route, route_len * sizeof(int));
+        printf("> Missao registrada para execucao\n");
+        pthread_cond_signal(&cond_mission_start);
+    }
+    pthread_mutex_unlock(&mutex_mission);
+}
+
+
 void *thread_receiver(void *_arg) {
     printf("[Thread Recepcao] Iniciada\n");
     char buffer[BUF_SIZE];
@@ -251,41 +388,30 @@ void *thread_receiver(void *_arg) {
 
             case MSG_EQUIPE_DRONE: {
                 payload_equipe_drone_t *order = (payload_equipe_drone_t *)(buffer + sizeof(header_t));
-                int city_id = ntohl(order->id_cidade);
-                int team_id = ntohl(order->id_equipe);
-
-                printf("\n[ORDEM DE DRONE RECEBIDA]\n");
-                printf("Cidade: %s (ID=%d)\n", amazonia_map.nodes[city_id].name, city_id);
-                printf("Equipe: %s (ID=%d)\n", amazonia_map.nodes[team_id].name, team_id);
+                handle_order(ntohl(order->id_cidade), ntohl(order->id_equipe), NULL, 0);
+                break;
+            }
 
-                
-                header_t ack_hdr;
-                payload_ack_t ack_pl;
-                ack_hdr.type = htons(MSG_ACK);
-                ack_hdr.length = htons(sizeof(payload_ack_t));
-                ack_pl.status = htonl(ACK_EQUIPE_DRONE);
-                
-                char ack_buf[sizeof(header_t) + sizeof(payload_ack_t)];
-                memcpy(ack_buf, &ack_hdr, sizeof(header_t));
-                memcpy(ack_buf + sizeof(header_t), &ack_pl, sizeof(payload_ack_t));
-                
-                send_udp_packet(ack_buf, sizeof(ack_buf));
-                printf("ACK enviado ao servidor\n");
+            case MSG_ROTA_EQUIPE: {
+                payload_rota_equipe_t *order = (payload_rota_equipe_t *)(buffer + sizeof(header_t));
+                int route_len = ntohl(order->total_nos);
+                if (route_len < 0 || route_len > MAX_NODES ||
+                    len < (ssize_t)(sizeof(header_t) + ROTA_EQUIPE_LEN(route_len))) {
+                    printf("Aviso: ordem com rota invalida descartada\n");
+                    break;
+                }
 
-                
-                pthread_mutex_lock(&mutex_mission);
-                if (current_mission.active) {
-                    
-                    
-                    printf("AVISO: Ja existe missao ativa localmente, nova ordem ignorada.\n");
-                } else {
-                    current_mission.city_id = city_id;
-                    current_mission.team_id = team_id;
-                    current_mission.active = 1;
-                    printf("> Missao registrada para execucao\n");
-                    pthread_cond_signal(&cond_mission_start);
+                int route[MAX_NODES];
+                int valid = 1;
+                for (int i = 0; i < route_len; i++) {
+                    route[i] = ntohl(order->nos[i]);
+                    if (route[i] < 0 || route[i] >= amazonia_map.num_nodes) valid = 0;
+                }
+                if (!valid) {
+                    printf("Aviso: ordem com rota invalida descartada\n");
+                    break;
                 }
-                pthread_mutex_unlock(&mutex_mission);
+                handle_order(ntohl(order->id_cidade), ntohl(order->id_equipe), route, route_len);
                 break;
             }
         }
@@ -294,15 +420,114 @@ void *thread_receiver(void *_arg) {
 }
 
 
+int open_fleet_channel(int ai_family) {
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = ai_family;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    if (getaddrinfo(NULL, MCAST_PORT, &hints, &res) != 0) {
+        return -1;
+    }
+
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(res);
+        return -1;
+    }
+
+    // varios clientes na mesma maquina escutam a mesma porta
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    if (bind(fd, res->ai_addr, res->ai_addrlen) < 0) {
+        perror("bind multicast");
+        freeaddrinfo(res);
+        close(fd);
+        return -1;
+    }
+    freeaddrinfo(res);
+
+    int rc;
+    if (ai_family == AF_INET6) {
+        struct ipv6_mreq mreq;
+        memset(&mreq, 0, sizeof(mreq));
+        inet_pton(AF_INET6, MCAST_GROUP_V6, &mreq.ipv6mr_multiaddr);
+        rc = setsockopt(fd, IPPROTO_IPV6, IPV6_JOIN_GROUP, &mreq, sizeof(mreq));
+    } else {
+        struct ip_mreq mreq;
+        memset(&mreq, 0, sizeof(mreq));
+        inet_pton(AF_INET, MCAST_GROUP_V4, &mreq.imr_multiaddr);
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        rc = setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
+    }
+
+    if (rc < 0) {
+        perror("Aviso: falha ao entrar no grupo multicast");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void *thread_fleet_status(void *_arg) {
+    (void)_arg;
+    printf("[Thread Status da Frota] Iniciada\n");
+    char buffer[BUF_SIZE];
+
+    while (1) {
+        ssize_t len = recvfrom(mcast_fd, buffer, BUF_SIZE, 0, NULL, NULL);
+        if (len < (ssize_t)(sizeof(header_t) + sizeof(payload_status_equipes_t))) continue;
+
+        header_t *header = (header_t *)buffer;
+        if (ntohs(header->type) != MSG_STATUS_EQUIPES) continue;
+
+        payload_status_equipes_t *status = (payload_status_equipes_t *)(buffer + sizeof(header_t));
+        int shard = ntohs(status->shard);
+        if (shard >= MAX_SHARDS) continue;
+
+        uint32_t mask[STATUS_MASK_WORDS];
+        for (int w = 0; w < STATUS_MASK_WORDS; w++) {
+            mask[w] = ntohl(status->livres[w]);
+        }
+
+        int freed = 0;
+        pthread_mutex_lock(&mutex_fleet);
+        if (memcmp(mask, fleet_free_mask[shard], sizeof(mask)) != 0) {
+            // o primeiro status de cada shard e so o estado inicial, nao uma liberacao
+            for (int w = 0; w < STATUS_MASK_WORDS && fleet_seen[shard]; w++) {
+                if (mask[w] & ~fleet_free_mask[shard][w]) freed = 1;
+            }
+            memcpy(fleet_free_mask[shard], mask, sizeof(mask));
+            printf("\n[STATUS DA FROTA] Shard %d: %d/%d equipes livres, %d missoes ativas\n",
+                   shard, ntohs(status->equipes_livres), ntohs(status->total_equipes),
+                   ntohs(status->missoes_ativas));
+        }
+        fleet_seen[shard] = 1;
+        pthread_mutex_unlock(&mutex_fleet);
+
+        if (freed) {
+            pthread_mutex_lock(&status_mutex);
+            fleet_team_freed = 1;
+            pthread_cond_signal(&cond_status_alert);
+            pthread_mutex_unlock(&status_mutex);
+        }
+    }
+    return NULL;
+}
+
+
 int main(int argc, char *argv[]) {
     
     if (argc < 2) {
-        printf("Uso: %s <v4|v6> [hostname]\n", argv[0]);
+        printf("Uso: %s <v4|v6> [hostname] [porta]\n", argv[0]);
         return 1;
     }
 
     const char *protocol_mode = argv[1];
     const char *hostname = (argc > 2) ? argv[2] : NULL; 
+    const char *port = (argc > 3) ? argv[3] : PORT;
 
     
     if (load_graph("grafo_amazonia_legal.txt", &amazonia_map) != 0) {
@@ -329,7 +554,7 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    if (getaddrinfo(hostname, PORT, &hints, &res) != 0) {
+    if (getaddrinfo(hostname, port, &hints, &res) != 0) {
         perror("getaddrinfo");
         return 1;
     }
@@ -345,7 +570,14 @@ int main(int argc, char *argv[]) {
     server_addr_len = res->ai_addrlen;
     freeaddrinfo(res);
 
-    printf("Conectado ao servidor %s:%s\n", hostname, PORT);
+    printf("Conectado ao servidor %s:%s\n", hostname, port);
+
+    mcast_fd = open_fleet_channel(hints.ai_family);
+    if (mcast_fd >= 0) {
+        printf("Inscrito no status da frota (porta %s)\n", MCAST_PORT);
+    } else {
+        printf("Status da frota indisponivel; relatorios nao serao antecipados quando equipes forem liberadas\n");
+    }
 
     
     pthread_t t1, t2, t3, t4;
@@ -354,6 +586,11 @@ int main(int argc, char *argv[]) {
     pthread_create(&t2, NULL, thread_telemetry, NULL);
     pthread_create(&t3, NULL, thread_receiver, NULL);
     pthread_create(&t4, NULL, thread_drone_sim, NULL);
+    if (mcast_fd >= 0) {
+        pthread_t t5;
+        pthread_create(&t5, NULL, thread_fleet_status, NULL);
+        pthread_detach(t5);
+    }
 
     printf("Todas as threads iniciadas. Pressione Ctrl+C para encerrar.\n");
 
@@ -2,20 +2,33 @@
 #define COMMON_H
 
 #include <stdint.h>
+#include "graph.h"
 
 #define PORT "8080"
 #define BUF_SIZE 2048
 
+#define MCAST_PORT "8090" // fora da faixa de portas dos shards (PORT + indice)
+#define MCAST_GROUP_V4 "239.255.80.80"
+#define MCAST_GROUP_V6 "ff15::8080"
+
 #define MSG_TELEMETRIA 1
 #define MSG_ACK 2
 #define MSG_EQUIPE_DRONE 3
 #define MSG_CONCLUSAO 4
+#define MSG_STATUS_EQUIPES 5
+#define MSG_EMPRESTIMO_PEDIDO 6
+#define MSG_EMPRESTIMO_RESPOSTA 7
+#define MSG_ROTA_EQUIPE 8
+#define MSG_ALERTA_ENCAMINHADO 9
+#define MSG_EMPRESTIMO_CONFIRMACAO 10
 
 #define ACK_TELEMETRIA 0
 #define ACK_EQUIPE_DRONE 1
 #define ACK_CONCLUSAO 2
 
 #define MAX_CITIES 50
+#define STATUS_MASK_WORDS ((MAX_NODES + 31) / 32) // bit i ==> no i do grafo
+#define MAX_SHARDS 8
 
 typedef struct __attribute__((packed)) {
     uint16_t type;
@@ -41,9 +54,58 @@ typedef struct __attribute__((packed)) {
     int id_equipe;
 } payload_equipe_drone_t;
 
+// Ordem de despacho com a rota completa (capital -> ... -> cidade).
+// Tamanho variavel: so os primeiros total_nos elementos de nos sao enviados.
+typedef struct __attribute__((packed)) {
+    int id_cidade;
+    int id_equipe;
+    int distancia;
+    int total_nos;
+    int nos[MAX_NODES]; // rota tem no maximo um no por vertice do grafo
+} payload_rota_equipe_t;
+
+#define ROTA_EQUIPE_LEN(n) (sizeof(payload_rota_equipe_t) - sizeof(int) * (MAX_NODES - (n)))
+
 typedef struct __attribute__((packed)) {
     int id_cidade;
     int id_equipe;
 } payload_conclusao_t;
 
+// Publicado no grupo multicast sempre que a disponibilidade das equipes muda.
+// Bit i de livres ==> equipe da capital i disponivel.
+typedef struct __attribute__((packed)) {
+    uint32_t seq;
+    uint16_t total_equipes;
+    uint16_t equipes_livres;
+    uint16_t missoes_ativas;
+    uint16_t shard; // cada shard publica apenas as equipes que possui
+    uint32_t livres[STATUS_MASK_WORDS];
+} payload_status_equipes_t;
+
+// Protocolo entre shards: pedido de uma equipe emprestada para uma cidade
+// e resposta com a equipe cedida (id_equipe = -1 ==> recusado). Quem pediu
+// confirma a equipe aceita com MSG_EMPRESTIMO_CONFIRMACAO (mesmo payload da resposta).
+typedef struct __attribute__((packed)) {
+    int id_pedido;
+    int id_cidade;
+    int distancia_max;
+} payload_emprestimo_pedido_t;
+
+typedef struct __attribute__((packed)) {
+    int id_pedido;
+    int id_cidade;
+    int id_equipe;
+    int distancia;
+} payload_emprestimo_resposta_t;
+
+// Alerta de uma cidade de outro shard, repassado ao dono com o endereco do
+// cliente que o reportou; o dono envia a ordem direto a esse cliente.
+typedef struct __attribute__((packed)) {
+    int id_cidade;
+    uint8_t familia; // 4 ou 6
+    uint8_t reservado;
+    uint16_t porta;
+    uint8_t endereco[16];
+} payload_alerta_encaminhado_t;
+
 #endif
\ No newline at end of file
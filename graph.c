@@ -1,11 +1,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include "graph.h"
 
+static int graph_generation = 0;
+
 void init_graph(Graph *g) {
     g->num_nodes = 0;
     g->num_edges = 0;
+    g->version = ++graph_generation;
     for (int i = 0; i < MAX_NODES; i++) {
         g->nodes[i].id = -1;
         g->nodes[i].type = -1;
@@ -110,10 +114,7 @@ int load_graph(const char *filename, Graph *g) {
         if (!fgets(line, sizeof(line), file)) break;
         int u, v, weight;
         if (sscanf(line, "%d %d %d", &u, &v, &weight) == 3) {
-            if (u >= 0 && u < MAX_NODES && v >= 0 && v < MAX_NODES) {
-                g->adj[u][v] = weight;
-                g->adj[v][u] = weight; 
-            }
+            set_edge(g, u, v, weight);
         }
     }
 
@@ -126,13 +127,20 @@ void print_graph(const Graph *g) {
     printf("Graph Loaded: %d nodes, %d edges\n", g->num_nodes, g->num_edges);
 }
 
-int find_nearest_drone(const Graph *g, int start_node, const int *team_status, int *distance_out) {
-    int dist[MAX_NODES];
+void set_edge(Graph *g, int u, int v, int weight) {
+    if (u < 0 || u >= MAX_NODES || v < 0 || v >= MAX_NODES) return;
+    g->adj[u][v] = weight;
+    g->adj[v][u] = weight;
+    g->version = ++graph_generation;
+}
+
+static void dijkstra(const Graph *g, int start_node, int *dist, int *pred) {
     int visited[MAX_NODES];
     int n = g->num_nodes;
 
     for (int i = 0; i < n; i++) {
         dist[i] = INF;
+        pred[i] = -1;
         visited[i] = 0;
     }
     dist[start_node] = 0;
@@ -153,23 +161,85 @@ int find_nearest_drone(const Graph *g, int start_node, const int *team_status, i
             if (!visited[v] && g->adj[u][v] != INF && dist[u] != INF && 
                 dist[u] + g->adj[u][v] < dist[v]) {
                 dist[v] = dist[u] + g->adj[u][v];
+                pred[v] = u;
             }
         }
     }
+}
 
-    int best_node = -1;
-    int min_dist = INF;
+// Regiao de cada no = capital mais proxima (Dijkstra com todas as capitais como origem).
+// Nos sem caminho ate nenhuma capital ficam com regiao -1.
+void compute_regions(const Graph *g, int *region_out) {
+    int dist[MAX_NODES];
+    int visited[MAX_NODES];
+    int n = g->num_nodes;
 
     for (int i = 0; i < n; i++) {
-        // no capital ==> tipo 1, time disponivel ==> status 0
-        if (g->nodes[i].type == 1 && team_status[i] == 0) {
-            if (dist[i] < min_dist) {
-                min_dist = dist[i];
-                best_node = i;
+        visited[i] = 0;
+        if (g->nodes[i].type == 1) {
+            dist[i] = 0;
+            region_out[i] = i;
+        } else {
+            dist[i] = INF;
+            region_out[i] = -1;
+        }
+    }
+
+    for (int count = 0; count < n; count++) {
+        int min = INF, u = -1;
+        for (int v = 0; v < n; v++) {
+            if (!visited[v] && dist[v] < min) {
+                min = dist[v];
+                u = v;
+            }
+        }
+
+        if (u == -1) break;
+
+        visited[u] = 1;
+
+        for (int v = 0; v < n; v++) {
+            if (!visited[v] && g->adj[u][v] != INF && dist[u] + g->adj[u][v] < dist[v]) {
+                dist[v] = dist[u] + g->adj[u][v];
+                region_out[v] = region_out[u];
             }
         }
     }
+}
 
-    if (distance_out) *distance_out = min_dist;
-    return best_node;
-}
\ No newline at end of file
+void route_cache_init(RouteCache *cache) {
+    for (int i = 0; i < MAX_NODES; i++) {
+        cache->trees[i].version = -1;
+    }
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+const ShortestPathTree *route_cache_get(RouteCache *cache, const Graph *g, int source) {
+    ShortestPathTree *tree = &cache->trees[source];
+    if (tree->version != g->version) {
+        dijkstra(g, source, tree->dist, tree->pred);
+        tree->version = g->version;
+        cache->misses++;
+    } else {
+        cache->hits++;
+    }
+    return tree;
+}
+
+int build_route(const ShortestPathTree *tree, int target, int *route_out) {
+    if (tree->dist[target] == INF) return 0;
+
+    // pred leva do destino de volta a origem; inverte no final
+    int len = 0;
+    for (int v = target; v != -1 && len < MAX_NODES; v = tree->pred[v]) {
+        route_out[len++] = v;
+    }
+
+    for (int i = 0; i < len / 2; i++) {
+        int tmp = route_out[i];
+        route_out[i] = route_out[len - 1 - i];
+        route_out[len - 1 - i] = tmp;
+    }
+    return len;
+}
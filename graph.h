@@ -17,12 +17,33 @@ typedef struct {
     int adj[MAX_NODES][MAX_NODES];
     int num_nodes;
     int num_edges;
+    int version; // muda a cada alteracao; invalida as arvores em cache
 } Graph;
 
+// Arvore de caminhos minimos a partir de uma origem (pred = -1 na origem e em nos inalcancaveis).
+typedef struct {
+    int version;
+    int dist[MAX_NODES];
+    int pred[MAX_NODES];
+} ShortestPathTree;
+
+// Uma arvore por capital de origem, calculada sob demanda.
+typedef struct {
+    ShortestPathTree trees[MAX_NODES];
+    unsigned long hits;
+    unsigned long misses;
+} RouteCache;
+
 void init_graph(Graph *g);
 int load_graph(const char *filename, Graph *g);
 void print_graph(const Graph *g);
+void set_edge(Graph *g, int u, int v, int weight);
+
+void compute_regions(const Graph *g, int *region_out);
 
-int find_nearest_drone(const Graph *g, int start_node, const int *team_status, int *distance_out);
+void route_cache_init(RouteCache *cache);
+const ShortestPathTree *route_cache_get(RouteCache *cache, const Graph *g, int source);
+// Caminho origem -> ... -> destino em route_out; retorna o numero de nos (0 se inalcancavel).
+int build_route(const ShortestPathTree *tree, int target, int *route_out);
 
 #endif // GRAPH_H
\ No newline at end of file
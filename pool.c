@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <string.h>
+#include "pool.h"
+
+void pool_init(BufferPool *pool) {
+    pool->free_count = POOL_SIZE;
+    for (int i = 0; i < POOL_SIZE; i++) {
+        pool->free_list[i] = POOL_SIZE - 1 - i;
+    }
+    pool->high_water = 0;
+    pool->acquired = 0;
+    pool->exhausted = 0;
+}
+
+int pool_acquire(BufferPool *pool) {
+    if (pool->free_count == 0) {
+        pool->exhausted++;
+        return POOL_NONE;
+    }
+
+    int handle = pool->free_list[--pool->free_count];
+    pool->acquired++;
+
+    int in_use = POOL_SIZE - pool->free_count;
+    if (in_use > pool->high_water) pool->high_water = in_use;
+
+    PacketBuf *buf = &pool->bufs[handle];
+    buf->len = 0;
+    buf->fd = -1;
+    buf->addr_len = 0;
+    return handle;
+}
+
+PacketBuf *pool_get(BufferPool *pool, int handle) {
+    return &pool->bufs[handle];
+}
+
+void pool_release(BufferPool *pool, int handle) {
+    if (handle < 0 || handle >= POOL_SIZE || pool->free_count == POOL_SIZE) return;
+    pool->free_list[pool->free_count++] = handle;
+}
+
+int pool_in_use(const BufferPool *pool) {
+    return POOL_SIZE - pool->free_count;
+}
+
+void arena_reset(Arena *arena) {
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    arena->used = 0;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    size_t aligned = (size + 7) & ~(size_t)7;
+    if (arena->used + aligned > ARENA_SIZE) {
+        arena->overflows++;
+        return NULL;
+    }
+
+    void *ptr = arena->mem + arena->used;
+    arena->used += aligned;
+    return ptr;
+}
@@ -0,0 +1,51 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <sys/socket.h>
+#include "common.h"
+
+#define CACHE_LINE 64
+#define POOL_SIZE 64       // buffers compartilhados por recepcao, despacho e envio
+#define POOL_BATCH_MAX 16  // datagramas recebidos por lote
+#define POOL_NONE -1
+#define ARENA_SIZE (8 * 1024)
+
+// Datagrama em transito entre os estagios; 'data' comeca alinhado a linha de cache.
+typedef struct __attribute__((aligned(CACHE_LINE))) {
+    char data[BUF_SIZE];
+    size_t len;
+    int fd;
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+} PacketBuf;
+
+typedef struct {
+    PacketBuf bufs[POOL_SIZE];
+    int free_list[POOL_SIZE]; // pilha: o buffer liberado por ultimo e o proximo a ser usado
+    int free_count;
+    int high_water;
+    unsigned long acquired;
+    unsigned long exhausted;
+} BufferPool;
+
+// Memoria temporaria de um lote, liberada de uma vez por arena_reset.
+typedef struct {
+    char mem[ARENA_SIZE] __attribute__((aligned(CACHE_LINE)));
+    size_t used;
+    size_t peak;
+    unsigned long overflows;
+} Arena;
+
+void pool_init(BufferPool *pool);
+// Retorna o handle de um buffer livre ou POOL_NONE se o pool estiver esgotado.
+int pool_acquire(BufferPool *pool);
+PacketBuf *pool_get(BufferPool *pool, int handle);
+void pool_release(BufferPool *pool, int handle);
+int pool_in_use(const BufferPool *pool);
+
+void arena_reset(Arena *arena);
+// Retorna NULL se a arena nao tiver espaco.
+void *arena_alloc(Arena *arena, size_t size);
+
+#endif // POOL_H
@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include "common.h"
+#include "capture.h"
+
+#define REPLAY_DRAIN_SEC 2
+
+typedef struct {
+    int id_cidade;
+    int id_equipe;
+} Order;
+
+typedef struct {
+    Order *items;
+    int count;
+    int capacity;
+} OrderList;
+
+int sockfd;
+struct sockaddr_storage server_addr;
+socklen_t server_addr_len;
+
+OrderList replayed_orders = { NULL, 0, 0 };
+unsigned long replies_received = 0;
+pthread_mutex_t orders_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+void order_list_add(OrderList *list, int city_id, int team_id) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        Order *items = realloc(list->items, capacity * sizeof(Order));
+        if (!items) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count].id_cidade = city_id;
+    list->items[list->count].id_equipe = team_id;
+    list->count++;
+}
+
+// Extrai a ordem de despacho de um datagrama enviado pelo servidor; retorna 0 se nao for uma ordem.
+int parse_order(const char *buffer, size_t len, int *city_id, int *team_id) {
+    if (len < sizeof(header_t)) return 0;
+
+    // capturas antigas tem MSG_EQUIPE_DRONE; as atuais, MSG_ROTA_EQUIPE (mesmo prefixo cidade/equipe)
+    const header_t *header = (const header_t *)buffer;
+    uint16_t type = ntohs(header->type);
+    if (type != MSG_EQUIPE_DRONE && type != MSG_ROTA_EQUIPE) return 0;
+    if (len < sizeof(header_t) + sizeof(payload_equipe_drone_t)) return 0;
+
+    const payload_equipe_drone_t *order = (const payload_equipe_drone_t *)(buffer + sizeof(header_t));
+    *city_id = ntohl(order->id_cidade);
+    *team_id = ntohl(order->id_equipe);
+    return 1;
+}
+
+long elapsed_usec(const struct timeval *from, const struct timeval *to) {
+    return (to->tv_sec - from->tv_sec) * 1000000L + (to->tv_usec - from->tv_usec);
+}
+
+
+void *thread_receiver(void *_arg) {
+    (void)_arg;
+    char buffer[BUF_SIZE];
+
+    while (1) {
+        ssize_t len = recvfrom(sockfd, buffer, BUF_SIZE, 0, NULL, NULL);
+        if (len < (ssize_t)sizeof(header_t)) continue;
+
+        int city_id, team_id;
+        pthread_mutex_lock(&orders_mutex);
+        replies_received++;
+        if (parse_order(buffer, len, &city_id, &team_id)) {
+            order_list_add(&replayed_orders, city_id, team_id);
+        }
+        pthread_mutex_unlock(&orders_mutex);
+    }
+    return NULL;
+}
+
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Uso: %s <v4|v6> <arquivo_captura> [velocidade|max] [hostname] [porta] [sessao]\n", argv[0]);
+        return 1;
+    }
+
+    const char *protocol_mode = argv[1];
+    const char *capture_file = argv[2];
+    const char *hostname = (argc > 4) ? argv[4] : NULL;
+    const char *port = (argc > 5) ? argv[5] : PORT;
+    int session = (argc > 6) ? atoi(argv[6]) : 1;
+    if (session < 1) {
+        fprintf(stderr, "Sessao invalida: %s (a primeira e 1)\n", argv[6]);
+        return 1;
+    }
+
+    // velocidade 1 = tempo original, 2 = duas vezes mais rapido, max = sem espera
+    double speed = 1.0;
+    if (argc > 3) {
+        if (strcmp(argv[3], "max") == 0) {
+            speed = 0.0;
+        } else {
+            speed = atof(argv[3]);
+            if (speed <= 0.0) {
+                fprintf(stderr, "Velocidade invalida: %s\n", argv[3]);
+                return 1;
+            }
+        }
+    }
+
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = SOCK_DGRAM;
+
+    if (strcmp(protocol_mode, "v6") == 0) {
+        hints.ai_family = AF_INET6;
+        if (!hostname) hostname = "::1";
+    } else if (strcmp(protocol_mode, "v4") == 0) {
+        hints.ai_family = AF_INET;
+        if (!hostname) hostname = "127.0.0.1";
+    } else {
+        fprintf(stderr, "Modo invalido: use 'v4' ou 'v6'\n");
+        return 1;
+    }
+
+    if (getaddrinfo(hostname, port, &hints, &res) != 0) {
+        perror("getaddrinfo");
+        return 1;
+    }
+
+    sockfd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (sockfd < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    memcpy(&server_addr, res->ai_addr, res->ai_addrlen);
+    server_addr_len = res->ai_addrlen;
+    freeaddrinfo(res);
+
+    Capture capture;
+    if (capture_open_read(&capture, capture_file) != 0) {
+        return 1;
+    }
+
+    pthread_t receiver;
+    pthread_create(&receiver, NULL, thread_receiver, NULL);
+
+    printf("Reproduzindo %s (sessao %d) contra %s:%s (velocidade: %s)\n",
+           capture_file, session, hostname, port, argc > 3 ? argv[3] : "1");
+
+    OrderList recorded_orders = { NULL, 0, 0 };
+    char data[BUF_SIZE];
+    capture_record_t rec;
+    unsigned long sent = 0;
+    int first = 1;
+    struct timeval capture_start, replay_start, now;
+
+    // cada sessao veio de um servidor recem-iniciado: reproduz so a escolhida
+    // (registros antes do primeiro marcador formam uma sessao propria)
+    int current_session = 0;
+    int session_found = 0;
+    int rc;
+    while ((rc = capture_next(&capture, &rec, data, sizeof(data))) == 1) {
+        if (rec.direction == CAPTURE_SESSION) {
+            current_session++;
+            if (current_session > session) break;
+            if (current_session == session) session_found = 1;
+            continue;
+        }
+        if (current_session == 0) {
+            current_session = 1;
+            if (session == 1) session_found = 1;
+        }
+        if (current_session != session) continue;
+
+        if (rec.direction == CAPTURE_TX) {
+            int city_id, team_id;
+            if (parse_order(data, rec.length, &city_id, &team_id)) {
+                order_list_add(&recorded_orders, city_id, team_id);
+            }
+            continue;
+        }
+
+        struct timeval ts = { rec.ts_sec, rec.ts_usec };
+        if (first) {
+            capture_start = ts;
+            gettimeofday(&replay_start, NULL);
+            first = 0;
+        }
+
+        if (speed > 0.0) {
+            long target = (long)(elapsed_usec(&capture_start, &ts) / speed);
+            gettimeofday(&now, NULL);
+            long wait = target - elapsed_usec(&replay_start, &now);
+            if (wait > 0) usleep(wait);
+        }
+
+        sendto(sockfd, data, rec.length, 0, (struct sockaddr *)&server_addr, server_addr_len);
+        sent++;
+    }
+
+    if (rc < 0) {
+        fprintf(stderr, "Aviso: registro corrompido apos %lu registros, reproducao interrompida\n",
+                capture.records);
+    }
+    capture_close(&capture);
+
+    if (!session_found) {
+        fprintf(stderr, "Erro: sessao %d nao encontrada em %s\n", session, capture_file);
+        return 1;
+    }
+
+    gettimeofday(&now, NULL);
+    double seconds = first ? 0.0 : elapsed_usec(&replay_start, &now) / 1e6;
+
+    printf("Aguardando respostas (%d s)...\n", REPLAY_DRAIN_SEC);
+    sleep(REPLAY_DRAIN_SEC);
+
+    pthread_mutex_lock(&orders_mutex);
+    printf("\n[RESULTADO DA REPRODUCAO]\n");
+    printf("Datagramas enviados: %lu em %.3f s", sent, seconds);
+    if (seconds > 0.0) printf(" (%.0f msg/s)", sent / seconds);
+    printf("\n");
+    printf("Respostas recebidas: %lu\n", replies_received);
+    printf("Ordens de despacho: %d gravadas, %d reproduzidas\n",
+           recorded_orders.count, replayed_orders.count);
+
+    int mismatches = 0;
+    int common = recorded_orders.count < replayed_orders.count ? recorded_orders.count : replayed_orders.count;
+    for (int i = 0; i < common; i++) {
+        Order *expected = &recorded_orders.items[i];
+        Order *got = &replayed_orders.items[i];
+        if (expected->id_cidade != got->id_cidade || expected->id_equipe != got->id_equipe) {
+            if (mismatches < 10) {
+                printf(" -> Divergencia na ordem %d: esperado cidade %d/equipe %d, obtido cidade %d/equipe %d\n",
+                       i, expected->id_cidade, expected->id_equipe, got->id_cidade, got->id_equipe);
+            }
+            mismatches++;
+        }
+    }
+    mismatches += abs(recorded_orders.count - replayed_orders.count);
+    pthread_mutex_unlock(&orders_mutex);
+
+    // sessao sem datagramas nao prova nada: conta como falha
+    int ok = (sent > 0 && mismatches == 0);
+    if (sent == 0) {
+        printf("FALHA: nenhum datagrama reproduzido na sessao %d\n", session);
+    } else if (mismatches == 0) {
+        printf("OK: decisoes de despacho identicas a captura\n");
+    } else {
+        printf("FALHA: %d divergencias nas decisoes de despacho\n", mismatches);
+    }
+
+    free(recorded_orders.items);
+    close(sockfd);
+    return ok ? 0 : 1;
+}
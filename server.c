@@ -4,32 +4,772 @@
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <signal.h>
+#include <sys/time.h>
 #include "common.h"
 #include "graph.h"
+#include "capture.h"
+#include "shard.h"
+#include "pool.h"
+#include "teams.h"
 
 Graph amazonia_graph;
-int drone_teams_status[MAX_NODES]; 
+RouteCache route_cache;
+TeamIndex drone_teams;     // bit livre por capital
+Bitset owned_teams;        // capitais deste shard (indices compactos)
 int city_mission_active[MAX_NODES]; 
 
-void send_ack(int socket_fd, struct sockaddr *dest_addr, socklen_t addr_len, int ack_type) {
-    header_t header;
-    payload_ack_t payload;
+Capture capture;
+int capture_enabled = 0;
+volatile sig_atomic_t running = 1;
+volatile sig_atomic_t report_pool = 0;
+
+int mcast_fd = -1;
+struct sockaddr_storage mcast_addr;
+socklen_t mcast_addr_len;
+uint32_t status_seq = 0;
+
+int sockfd;
+ShardConfig shard;
+Loan loans[MAX_PENDING_LOANS];
+Lend lends[MAX_PENDING_LOANS];
+int next_loan_id = 1;
+
+// Recepcao, despacho e envio trocam datagramas por handle do pool;
+// listas temporarias de cada lote ficam na arena.
+BufferPool pool;
+Arena batch_arena;
+int *tx_queue;
+int tx_count = 0;
+int status_dirty = 0;
+
+void handle_sigint(int _sig) {
+    (void)_sig;
+    running = 0;
+}
+
+void handle_sigusr1(int _sig) {
+    (void)_sig;
+    report_pool = 1;
+}
+
+void print_pool_stats(void) {
+    printf("\n[POOL] em uso: %d/%d, pico: %d, alocacoes: %lu, esgotado: %lu vezes | arena: pico %zu/%d bytes, estouros: %lu\n",
+           pool_in_use(&pool), POOL_SIZE, pool.high_water, pool.acquired, pool.exhausted,
+           batch_arena.peak, ARENA_SIZE, batch_arena.overflows);
+    printf("[ROTAS] arvores em cache: %lu consultas, %lu calculos de Dijkstra\n",
+           route_cache.hits, route_cache.misses);
+}
+
+// Estagio de envio: transmite a fila do lote e devolve os buffers ao pool.
+void flush_tx(void) {
+    for (int i = 0; i < tx_count; i++) {
+        PacketBuf *out = pool_get(&pool, tx_queue[i]);
+        sendto(out->fd, out->data, out->len, 0, (struct sockaddr *)&out->addr, out->addr_len);
+        if (capture_enabled && out->fd == sockfd) {
+            capture_write(&capture, CAPTURE_TX, (struct sockaddr *)&out->addr, out->data, (uint16_t)out->len);
+        }
+        pool_release(&pool, tx_queue[i]);
+    }
+    tx_count = 0;
+}
+
+void begin_batch(void) {
+    arena_reset(&batch_arena);
+    tx_queue = arena_alloc(&batch_arena, POOL_SIZE * sizeof(int));
+    tx_count = 0;
+}
+
+// Reserva um buffer de saida; com o pool esgotado, esvazia a fila de envio antes.
+int tx_begin(int fd, const struct sockaddr *dest_addr, socklen_t addr_len) {
+    int handle = pool_acquire(&pool);
+    if (handle == POOL_NONE) {
+        flush_tx();
+        handle = pool_acquire(&pool);
+        if (handle == POOL_NONE) {
+            printf("Warning: pool de buffers esgotado, datagrama descartado.\n");
+            return POOL_NONE;
+        }
+    }
+
+    PacketBuf *out = pool_get(&pool, handle);
+    out->fd = fd;
+    memcpy(&out->addr, dest_addr, addr_len);
+    out->addr_len = addr_len;
+    return handle;
+}
+
+void tx_commit(int handle, size_t len) {
+    pool_get(&pool, handle)->len = len;
+    tx_queue[tx_count++] = handle;
+}
+
+// Responde reaproveitando o buffer recebido, reescrito no lugar, para o mesmo remetente.
+void tx_reply(int handle, size_t len) {
+    PacketBuf *buf = pool_get(&pool, handle);
+    buf->fd = sockfd;
+    buf->len = len;
+    tx_queue[tx_count++] = handle;
+}
+
+// Reencaminha um datagrama recebido sem copia-lo: o proprio handle vai para a fila de envio.
+void tx_forward(int handle, const struct sockaddr *dest_addr, socklen_t addr_len) {
+    PacketBuf *buf = pool_get(&pool, handle);
+    memcpy(&buf->addr, dest_addr, addr_len);
+    buf->addr_len = addr_len;
+    tx_reply(handle, buf->len);
+}
+
+void send_ack(struct sockaddr *dest_addr, socklen_t addr_len, int ack_type) {
+    int handle = tx_begin(sockfd, dest_addr, addr_len);
+    if (handle == POOL_NONE) return;
+
+    PacketBuf *out = pool_get(&pool, handle);
+    header_t *header = (header_t *)out->data;
+    payload_ack_t *payload = (payload_ack_t *)(out->data + sizeof(header_t));
+
+    header->type = htons(MSG_ACK);
+    header->length = htons(sizeof(payload_ack_t));
+    payload->status = htonl(ack_type); 
+
+    tx_commit(handle, sizeof(header_t) + sizeof(payload_ack_t));
+}
+
+int open_status_channel(int ai_family) {
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = ai_family;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    const char *group = (ai_family == AF_INET6) ? MCAST_GROUP_V6 : MCAST_GROUP_V4;
+    if (getaddrinfo(group, MCAST_PORT, &hints, &res) != 0) {
+        fprintf(stderr, "Aviso: grupo multicast %s invalido\n", group);
+        return -1;
+    }
 
-    header.type = htons(MSG_ACK);
-    header.length = htons(sizeof(payload_ack_t));
-    payload.status = htonl(ack_type); 
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd < 0) {
+        perror("socket multicast");
+        freeaddrinfo(res);
+        return -1;
+    }
+
+    // restrito a rede local
+    if (res->ai_family == AF_INET6) {
+        int hops = 1;
+        setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &hops, sizeof(hops));
+    } else {
+        unsigned char ttl = 1;
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    }
+
+    memcpy(&mcast_addr, res->ai_addr, res->ai_addrlen);
+    mcast_addr_len = res->ai_addrlen;
+    freeaddrinfo(res);
+
+    printf("Status das equipes publicado em %s:%s\n", group, MCAST_PORT);
+    return fd;
+}
+
+void publish_team_status(void) {
+    if (mcast_fd < 0) return;
+
+    int handle = tx_begin(mcast_fd, (struct sockaddr *)&mcast_addr, mcast_addr_len);
+    if (handle == POOL_NONE) return;
+
+    PacketBuf *out = pool_get(&pool, handle);
+    header_t *header = (header_t *)out->data;
+    payload_status_equipes_t *payload = (payload_status_equipes_t *)(out->data + sizeof(header_t));
+    memset(payload, 0, sizeof(*payload));
+
+    int total = bitset_count(&owned_teams);
+    int free_teams = team_count_free_in(&drone_teams, &owned_teams);
+
+    // no protocolo o bit e o ID do no; percorre so os bits livres
+    uint32_t mask[STATUS_MASK_WORDS] = {0};
+    for (int w = 0; w < BITSET_WORDS; w++) {
+        uint64_t bits = drone_teams.free.w[w] & owned_teams.w[w];
+        while (bits) {
+            int node = drone_teams.node[w * 64 + __builtin_ctzll(bits)];
+            mask[node / 32] |= 1u << (node % 32);
+            bits &= bits - 1;
+        }
+    }
 
+    int missions = 0;
+    for (int i = 0; i < amazonia_graph.num_nodes; i++) {
+        if (city_mission_active[i]) missions++;
+    }
+
+    header->type = htons(MSG_STATUS_EQUIPES);
+    header->length = htons(sizeof(payload_status_equipes_t));
+    payload->seq = htonl(++status_seq);
+    payload->total_equipes = htons(total);
+    payload->equipes_livres = htons(free_teams);
+    payload->missoes_ativas = htons(missions);
+    payload->shard = htons(shard.index);
+    for (int w = 0; w < STATUS_MASK_WORDS; w++) {
+        payload->livres[w] = htonl(mask[w]);
+    }
+
+    tx_commit(handle, sizeof(header_t) + sizeof(payload_status_equipes_t));
+    status_dirty = 0;
+}
+
+void dispatch_team(int city_id, int team_id, int dist, struct sockaddr *client_addr, socklen_t addr_len) {
+    printf("\n[DESPACHANDO DRONES]\n");
+    printf("Cidade em alerta: %s (ID=%d)\n", amazonia_graph.nodes[city_id].name, city_id);
+    printf("> Dijkstra: Capital %s (ID=%d) selecionada, distancia = %d km\n", 
+           amazonia_graph.nodes[team_id].name, team_id, dist);
+
+    const ShortestPathTree *tree = route_cache_get(&route_cache, &amazonia_graph, team_id);
+    
     
-    char buffer[sizeof(header_t) + sizeof(payload_ack_t)];
-    memcpy(buffer, &header, sizeof(header_t));
-    memcpy(buffer + sizeof(header_t), &payload, sizeof(payload_ack_t));
+    team_set_free(&drone_teams, team_id, 0);
+    city_mission_active[city_id] = 1;
+    status_dirty = 1;
 
-    sendto(socket_fd, buffer, sizeof(buffer), 0, dest_addr, addr_len);
+    
+    int handle = tx_begin(sockfd, client_addr, addr_len);
+    if (handle == POOL_NONE) return;
+
+    PacketBuf *out = pool_get(&pool, handle);
+    header_t *resp_header = (header_t *)out->data;
+    payload_rota_equipe_t *resp_payload = (payload_rota_equipe_t *)(out->data + sizeof(header_t));
+
+    int route[MAX_NODES];
+    int route_len = build_route(tree, city_id, route);
+    for (int i = 0; i < route_len; i++) {
+        resp_payload->nos[i] = htonl(route[i]);
+    }
+
+    resp_header->type = htons(MSG_ROTA_EQUIPE);
+    resp_header->length = htons(ROTA_EQUIPE_LEN(route_len));
+    
+    resp_payload->id_cidade = htonl(city_id);
+    resp_payload->id_equipe = htonl(team_id);
+    resp_payload->distancia = htonl(dist);
+    resp_payload->total_nos = htonl(route_len);
+
+    tx_commit(handle, sizeof(header_t) + ROTA_EQUIPE_LEN(route_len));
+    printf("> Ordem enviada: Equipe %s (ID=%d) -> Cidade %s (ID=%d)\n",
+           amazonia_graph.nodes[team_id].name, team_id, 
+           amazonia_graph.nodes[city_id].name, city_id);
+}
+
+void dispatch_local(int city_id, struct sockaddr *client_addr, socklen_t addr_len) {
+    int dist = -1;
+    int best_team = team_nearest_free(&drone_teams, &route_cache, &amazonia_graph, city_id, &dist);
+
+    if (best_team != -1) {
+        dispatch_team(city_id, best_team, dist, client_addr, addr_len);
+    } else {
+        printf("ALERTA CRÍTICO: Nenhuma equipe de drones disponível para %s!\n", 
+               amazonia_graph.nodes[city_id].name);
+    }
+}
+
+void set_deadline(struct timeval *deadline, int ms) {
+    gettimeofday(deadline, NULL);
+    deadline->tv_usec += ms * 1000;
+    deadline->tv_sec += deadline->tv_usec / 1000000;
+    deadline->tv_usec %= 1000000;
+}
+
+int deadline_passed(const struct timeval *deadline, const struct timeval *now) {
+    return now->tv_sec > deadline->tv_sec ||
+           (now->tv_sec == deadline->tv_sec && now->tv_usec >= deadline->tv_usec);
+}
+
+void send_loan_request(Loan *loan) {
+    int handle = tx_begin(sockfd, (struct sockaddr *)&shard.peers[loan->peer], shard.peer_len[loan->peer]);
+    if (handle != POOL_NONE) {
+        PacketBuf *out = pool_get(&pool, handle);
+        header_t *header = (header_t *)out->data;
+        payload_emprestimo_pedido_t *payload = (payload_emprestimo_pedido_t *)(out->data + sizeof(header_t));
+
+        header->type = htons(MSG_EMPRESTIMO_PEDIDO);
+        header->length = htons(sizeof(payload_emprestimo_pedido_t));
+        payload->id_pedido = htonl(loan->id_pedido);
+        payload->id_cidade = htonl(loan->city_id);
+        payload->distancia_max = htonl(loan->local_dist);
+
+        tx_commit(handle, sizeof(header_t) + sizeof(payload_emprestimo_pedido_t));
+    }
+
+    // sem buffer o pedido expira e o proximo shard e consultado
+    set_deadline(&loan->deadline, LOAN_TIMEOUT_MS);
+
+    printf("> Pedindo equipe emprestada ao shard %d para %s\n",
+           loan->peer, amazonia_graph.nodes[loan->city_id].name);
+}
+
+// Equipe local ocupada ou distante demais: pergunta aos outros shards, um de cada vez.
+void start_loan(int city_id, int local_team, int local_dist, struct sockaddr *client_addr, socklen_t addr_len) {
+    Loan *loan = NULL;
+    for (int i = 0; i < MAX_PENDING_LOANS; i++) {
+        if (!loans[i].active) {
+            loan = &loans[i];
+            break;
+        }
+    }
+
+    if (!loan) {
+        dispatch_local(city_id, client_addr, addr_len);
+        return;
+    }
+
+    loan->active = 1;
+    loan->id_pedido = next_loan_id++;
+    loan->city_id = city_id;
+    loan->local_team = local_team;
+    loan->local_dist = (local_team == -1) ? INF : local_dist;
+    loan->peer = (shard.index + 1) % shard.total;
+    loan->tried = 0;
+    memcpy(&loan->client_addr, client_addr, addr_len);
+    loan->client_len = addr_len;
+
+    // reserva a cidade enquanto o emprestimo esta pendente
+    city_mission_active[city_id] = 1;
+    send_loan_request(loan);
+}
+
+void advance_loan(Loan *loan) {
+    loan->tried++;
+    if (loan->tried < shard.total - 1) {
+        loan->peer = (loan->peer + 1) % shard.total;
+        if (loan->peer == shard.index) loan->peer = (loan->peer + 1) % shard.total;
+        send_loan_request(loan);
+        return;
+    }
+
+    // todos recusaram ==> usa a melhor equipe local que ainda estiver livre
+    loan->active = 0;
+    city_mission_active[loan->city_id] = 0;
+    dispatch_local(loan->city_id, (struct sockaddr *)&loan->client_addr, loan->client_len);
+}
+
+void expire_loans(void) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    for (int i = 0; i < MAX_PENDING_LOANS; i++) {
+        Loan *loan = &loans[i];
+        if (!loan->active) continue;
+        if (deadline_passed(&loan->deadline, &now)) {
+            printf(" -> Shard %d nao respondeu ao pedido de emprestimo %d\n", loan->peer, loan->id_pedido);
+            advance_loan(loan);
+        }
+    }
+
+    // resposta ou confirmacao perdida: a equipe cedida volta para este shard
+    for (int i = 0; i < MAX_PENDING_LOANS; i++) {
+        Lend *lend = &lends[i];
+        if (!lend->active || !deadline_passed(&lend->deadline, &now)) continue;
+
+        lend->active = 0;
+        team_set_free(&drone_teams, lend->team, 1);
+        status_dirty = 1;
+        printf(" -> Shard %d nao confirmou o emprestimo %d; equipe %s liberada\n",
+               lend->peer, lend->id_pedido, amazonia_graph.nodes[lend->team].name);
+    }
+}
+
+void release_lend(int team_id) {
+    for (int i = 0; i < MAX_PENDING_LOANS; i++) {
+        if (lends[i].active && lends[i].team == team_id) lends[i].active = 0;
+    }
+}
+
+// Cidade de outro shard: so o dono despacha, com a ordem indo direto ao cliente.
+void forward_alert(int city_id, const struct sockaddr *client_addr) {
+    int owner = shard.owner[city_id];
+    int handle = tx_begin(sockfd, (struct sockaddr *)&shard.peers[owner], shard.peer_len[owner]);
+    if (handle == POOL_NONE) return;
+
+    PacketBuf *out = pool_get(&pool, handle);
+    header_t *header = (header_t *)out->data;
+    payload_alerta_encaminhado_t *payload = (payload_alerta_encaminhado_t *)(out->data + sizeof(header_t));
+    memset(payload, 0, sizeof(*payload));
+
+    if (client_addr->sa_family == AF_INET6) {
+        const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *)client_addr;
+        payload->familia = 6;
+        payload->porta = in6->sin6_port;
+        memcpy(payload->endereco, &in6->sin6_addr, sizeof(in6->sin6_addr));
+    } else {
+        const struct sockaddr_in *in4 = (const struct sockaddr_in *)client_addr;
+        payload->familia = 4;
+        payload->porta = in4->sin_port;
+        memcpy(payload->endereco, &in4->sin_addr, sizeof(in4->sin_addr));
+    }
+
+    header->type = htons(MSG_ALERTA_ENCAMINHADO);
+    header->length = htons(sizeof(payload_alerta_encaminhado_t));
+    payload->id_cidade = htonl(city_id);
+
+    tx_commit(handle, sizeof(header_t) + sizeof(payload_alerta_encaminhado_t));
+    printf(" -> %s pertence ao shard %d, alerta repassado\n", amazonia_graph.nodes[city_id].name, owner);
+}
+
+void handle_alert(int city_id, struct sockaddr *client_addr, socklen_t addr_len) {
+    printf("ALERTA: %s (ID=%d)\n", amazonia_graph.nodes[city_id].name, city_id);
+
+    if (!shard_owns(&shard, city_id)) {
+        forward_alert(city_id, client_addr);
+        return;
+    }
+
+    if (city_mission_active[city_id] == 1) {
+        printf(" -> Já existe equipe atuando em %s. Alerta ignorado.\n", amazonia_graph.nodes[city_id].name);
+        return;
+    }
+
+    
+    int dist = -1;
+    int best_team = team_nearest_free(&drone_teams, &route_cache, &amazonia_graph, city_id, &dist);
+
+    if (shard.total > 1 && (best_team == -1 || dist > SHARD_FAR_KM)) {
+        start_loan(city_id, best_team, dist, client_addr, addr_len);
+    } else if (best_team != -1) {
+        dispatch_team(city_id, best_team, dist, client_addr, addr_len);
+    } else {
+        printf("ALERTA CRÍTICO: Nenhuma equipe de drones disponível para %s!\n", 
+               amazonia_graph.nodes[city_id].name);
+    }
+}
+
+// Estagio de recepcao: bloqueia pelo primeiro datagrama e drena o que ja estiver
+// na fila do socket, ate POOL_BATCH_MAX, cada um direto em um buffer do pool.
+int receive_batch(int *rx_handles) {
+    if (!rx_handles) return 0;
+
+    int count = 0;
+    while (count < POOL_BATCH_MAX) {
+        int handle = pool_acquire(&pool);
+        if (handle == POOL_NONE) break;
+
+        PacketBuf *in = pool_get(&pool, handle);
+        in->addr_len = sizeof(in->addr);
+        ssize_t received_bytes = recvfrom(sockfd, in->data, BUF_SIZE, count == 0 ? 0 : MSG_DONTWAIT,
+                                          (struct sockaddr *)&in->addr, &in->addr_len);
+        if (received_bytes < 0) {
+            pool_release(&pool, handle);
+            break;
+        }
+
+        if (capture_enabled) {
+            capture_write(&capture, CAPTURE_RX, (struct sockaddr *)&in->addr, in->data, (uint16_t)received_bytes);
+        }
+
+        in->len = received_bytes;
+        in->fd = sockfd;
+        rx_handles[count++] = handle;
+    }
+    return count;
+}
+
+// Estagio de despacho. Retorna 1 se o handle foi repassado a fila de envio
+// (e nao deve ser liberado pelo chamador).
+int handle_packet(int handle) {
+    PacketBuf *in = pool_get(&pool, handle);
+    struct sockaddr *client_addr = (struct sockaddr *)&in->addr;
+    socklen_t addr_len = in->addr_len;
+
+    if (in->len < sizeof(header_t)) return 0; 
+
+    header_t *header = (header_t *)in->data;
+    uint16_t msg_type = ntohs(header->type);
+    uint16_t msg_len = ntohs(header->length);
+
+    if (in->len < sizeof(header_t) + msg_len) {
+        printf("Warning: Packet truncated.\n");
+        return 0;
+    }
+
+    switch (msg_type) {
+        case MSG_TELEMETRIA: {
+            printf("\n[TELEMETRIA RECEBIDA]\n");
+            payload_telemetria_t *telemetria = (payload_telemetria_t *)(in->data + sizeof(header_t));
+            
+            
+            send_ack(client_addr, addr_len, ACK_TELEMETRIA);
+
+            
+            int total_cities = ntohl(telemetria->total); 
+            
+            printf("Total de cidades monitoradas: %d\n", total_cities);
+
+            // primeiro separa os alertas do lote, depois despacha cada um
+            int *alerts = arena_alloc(&batch_arena, MAX_CITIES * sizeof(int));
+            int alert_count = 0;
+
+            for (int i = 0; i < total_cities && i < MAX_CITIES; i++) {
+                int city_id = ntohl(telemetria->dados[i].id_cidade);
+                int city_status = ntohl(telemetria->dados[i].status);
+
+                if (city_status == 1) {
+                    if (alerts) {
+                        alerts[alert_count++] = city_id;
+                    } else {
+                        handle_alert(city_id, client_addr, addr_len);
+                    }
+                }
+            }
+
+            for (int i = 0; i < alert_count; i++) {
+                handle_alert(alerts[i], client_addr, addr_len);
+            }
+            break;
+        }
+
+        case MSG_ACK: {
+            payload_ack_t *ack = (payload_ack_t *)(in->data + sizeof(header_t));
+            int status = ntohl(ack->status);
+            printf("\n[ACK RECEBIDO] Status: %d\n", status);
+            if (status == ACK_EQUIPE_DRONE) {
+                printf("Cliente confirmou recebimento de ordem de drone.\n");
+            }
+            break;
+        }
+
+        case MSG_CONCLUSAO: {
+            payload_conclusao_t *conclusao = (payload_conclusao_t *)(in->data + sizeof(header_t));
+            
+            int city_id = ntohl(conclusao->id_cidade);
+            int team_id = ntohl(conclusao->id_equipe);
+
+            if (city_id < 0 || city_id >= amazonia_graph.num_nodes ||
+                team_id < 0 || team_id >= amazonia_graph.num_nodes) {
+                printf("Aviso: conclusao invalida descartada\n");
+                break;
+            }
+
+            // a conclusao passa pelo dono da cidade (encerra a missao) e pelo dono
+            // da equipe (libera a equipe); cada shard repassa a parte que nao e sua
+            int sender = shard_peer_index(&shard, client_addr);
+            if (sender < 0) {
+                printf("\n[MISSAO CONCLUIDA]\n");
+                printf("Cidade atendida: %s (ID=%d)\n", amazonia_graph.nodes[city_id].name, city_id);
+                printf("Equipe: %s (ID=%d)\n", amazonia_graph.nodes[team_id].name, team_id);
+                send_ack(client_addr, addr_len, ACK_CONCLUSAO);
+            }
+
+            if (shard_owns(&shard, city_id)) {
+                city_mission_active[city_id] = 0;
+            }
+
+            if (shard_owns(&shard, team_id)) {
+                release_lend(team_id);
+                team_set_free(&drone_teams, team_id, 1);
+                status_dirty = 1;
+                printf("Equipe %s (ID=%d) liberada para novas missoes\n", amazonia_graph.nodes[team_id].name, team_id);
+            }
+
+            int next = -1;
+            if (sender < 0 && !shard_owns(&shard, city_id)) {
+                next = shard.owner[city_id];
+            } else if (shard_owns(&shard, city_id) && !shard_owns(&shard, team_id) &&
+                       sender != shard.owner[team_id]) {
+                next = shard.owner[team_id];
+            }
+
+            if (next >= 0) {
+                tx_forward(handle, (struct sockaddr *)&shard.peers[next], shard.peer_len[next]);
+                printf("Conclusao repassada ao shard %d\n", next);
+                return 1;
+            }
+            break;
+        }
+
+        case MSG_ALERTA_ENCAMINHADO: {
+            payload_alerta_encaminhado_t *alerta = (payload_alerta_encaminhado_t *)(in->data + sizeof(header_t));
+            int city_id = ntohl(alerta->id_cidade);
+
+            if (shard_peer_index(&shard, client_addr) < 0 || city_id < 0 ||
+                city_id >= amazonia_graph.num_nodes || !shard_owns(&shard, city_id)) {
+                printf("Aviso: alerta repassado invalido descartado\n");
+                break;
+            }
+
+            struct sockaddr_storage origin;
+            socklen_t origin_len;
+            memset(&origin, 0, sizeof(origin));
+            if (alerta->familia == 6) {
+                struct sockaddr_in6 *in6 = (struct sockaddr_in6 *)&origin;
+                in6->sin6_family = AF_INET6;
+                in6->sin6_port = alerta->porta;
+                memcpy(&in6->sin6_addr, alerta->endereco, sizeof(in6->sin6_addr));
+                origin_len = sizeof(*in6);
+            } else {
+                struct sockaddr_in *in4 = (struct sockaddr_in *)&origin;
+                in4->sin_family = AF_INET;
+                in4->sin_port = alerta->porta;
+                memcpy(&in4->sin_addr, alerta->endereco, sizeof(in4->sin_addr));
+                origin_len = sizeof(*in4);
+            }
+
+            printf("\n[ALERTA REPASSADO PELO SHARD %d]\n", shard_peer_index(&shard, client_addr));
+            handle_alert(city_id, (struct sockaddr *)&origin, origin_len);
+            break;
+        }
+
+        case MSG_EMPRESTIMO_PEDIDO: {
+            payload_emprestimo_pedido_t *pedido = (payload_emprestimo_pedido_t *)(in->data + sizeof(header_t));
+            int loan_id = pedido->id_pedido;
+            int city_id = ntohl(pedido->id_cidade);
+            int max_dist = ntohl(pedido->distancia_max);
+
+            int sender = shard_peer_index(&shard, client_addr);
+            if (sender < 0 || city_id < 0 || city_id >= amazonia_graph.num_nodes) {
+                printf("Aviso: pedido de emprestimo invalido descartado\n");
+                break;
+            }
+
+            Lend *lend = NULL;
+            for (int i = 0; i < MAX_PENDING_LOANS; i++) {
+                if (!lends[i].active) {
+                    lend = &lends[i];
+                    break;
+                }
+            }
+
+            // cidade propria nunca deveria chegar como pedido: o dono despacha sem emprestimo
+            int dist = -1;
+            int best_team = team_nearest_free(&drone_teams, &route_cache, &amazonia_graph, city_id, &dist);
+            if (lend && !shard_owns(&shard, city_id) && best_team != -1 && dist < max_dist) {
+                team_set_free(&drone_teams, best_team, 0);
+                status_dirty = 1;
+
+                // reservada ate a confirmacao; sem ela a equipe volta em LEND_HOLD_MS
+                lend->active = 1;
+                lend->id_pedido = ntohl(loan_id);
+                lend->peer = sender;
+                lend->team = best_team;
+                set_deadline(&lend->deadline, LEND_HOLD_MS);
+
+                printf("\n[EMPRESTIMO] Equipe %s (ID=%d) cedida para %s, distancia = %d km\n",
+                       amazonia_graph.nodes[best_team].name, best_team,
+                       amazonia_graph.nodes[city_id].name, dist);
+            } else {
+                best_team = -1;
+                dist = INF;
+            }
+
+            // o pedido vira a resposta no mesmo buffer
+            payload_emprestimo_resposta_t *resp_payload = (payload_emprestimo_resposta_t *)(in->data + sizeof(header_t));
+
+            header->type = htons(MSG_EMPRESTIMO_RESPOSTA);
+            header->length = htons(sizeof(payload_emprestimo_resposta_t));
+            resp_payload->id_pedido = loan_id;
+            resp_payload->id_cidade = htonl(city_id);
+            resp_payload->id_equipe = htonl(best_team);
+            resp_payload->distancia = htonl(dist);
+
+            tx_reply(handle, sizeof(header_t) + sizeof(payload_emprestimo_resposta_t));
+            return 1;
+        }
+
+        case MSG_EMPRESTIMO_RESPOSTA: {
+            payload_emprestimo_resposta_t *resposta = (payload_emprestimo_resposta_t *)(in->data + sizeof(header_t));
+            int loan_id = ntohl(resposta->id_pedido);
+            int city_id = ntohl(resposta->id_cidade);
+            int team_id = ntohl(resposta->id_equipe);
+            int dist = ntohl(resposta->distancia);
+
+            int sender = shard_peer_index(&shard, client_addr);
+            if (sender < 0 || city_id < 0 || city_id >= amazonia_graph.num_nodes ||
+                team_id < -1 || team_id >= amazonia_graph.num_nodes) {
+                printf("Aviso: resposta de emprestimo invalida descartada\n");
+                break;
+            }
+
+            // so vale a resposta do shard consultado no momento
+            Loan *loan = NULL;
+            for (int i = 0; i < MAX_PENDING_LOANS; i++) {
+                if (loans[i].active && loans[i].id_pedido == loan_id && loans[i].peer == sender) {
+                    loan = &loans[i];
+                    break;
+                }
+            }
+
+            if (!loan) {
+                // resposta atrasada: devolve a equipe para nao deixa-la presa
+                if (team_id != -1) {
+                    payload_conclusao_t *ret_payload = (payload_conclusao_t *)(in->data + sizeof(header_t));
+
+                    header->type = htons(MSG_CONCLUSAO);
+                    header->length = htons(sizeof(payload_conclusao_t));
+                    ret_payload->id_cidade = htonl(city_id);
+                    ret_payload->id_equipe = htonl(team_id);
+
+                    tx_reply(handle, sizeof(header_t) + sizeof(payload_conclusao_t));
+                    return 1;
+                }
+                break;
+            }
+
+            if (team_id == -1) {
+                printf(" -> Shard %d recusou o emprestimo para %s\n", loan->peer, amazonia_graph.nodes[city_id].name);
+                advance_loan(loan);
+                break;
+            }
+
+            loan->active = 0;
+            dispatch_team(city_id, team_id, dist, (struct sockaddr *)&loan->client_addr, loan->client_len);
+
+            // a resposta volta ao dono como confirmacao de que a equipe foi aceita
+            header->type = htons(MSG_EMPRESTIMO_CONFIRMACAO);
+            tx_reply(handle, sizeof(header_t) + sizeof(payload_emprestimo_resposta_t));
+            return 1;
+        }
+
+        case MSG_EMPRESTIMO_CONFIRMACAO: {
+            payload_emprestimo_resposta_t *confirmacao = (payload_emprestimo_resposta_t *)(in->data + sizeof(header_t));
+            int loan_id = ntohl(confirmacao->id_pedido);
+            int team_id = ntohl(confirmacao->id_equipe);
+
+            int sender = shard_peer_index(&shard, client_addr);
+            if (sender < 0 || team_id < 0 || team_id >= amazonia_graph.num_nodes || !shard_owns(&shard, team_id)) {
+                printf("Aviso: confirmacao de emprestimo invalida descartada\n");
+                break;
+            }
+
+            int found = 0;
+            for (int i = 0; i < MAX_PENDING_LOANS; i++) {
+                if (lends[i].active && lends[i].id_pedido == loan_id && lends[i].peer == sender &&
+                    lends[i].team == team_id) {
+                    lends[i].active = 0;
+                    found = 1;
+                    break;
+                }
+            }
+
+            // confirmacao depois do prazo: retoma a equipe se ela ainda estiver livre
+            if (!found) {
+                if (team_is_free(&drone_teams, team_id)) {
+                    team_set_free(&drone_teams, team_id, 0);
+                    status_dirty = 1;
+                    printf("Emprestimo %d confirmado apos o prazo; equipe %s retomada pelo shard %d\n",
+                           loan_id, amazonia_graph.nodes[team_id].name, sender);
+                } else {
+                    printf("AVISO: emprestimo %d confirmado apos o prazo, mas a equipe %s ja foi reutilizada\n",
+                           loan_id, amazonia_graph.nodes[team_id].name);
+                }
+            }
+            break;
+        }
+
+        default:
+            printf("Mensagem desconhecida recebida: %d\n", msg_type);
+    }
+
+    return 0;
 }
 
 int main(int argc, char *argv[]) {
     if (argc < 2) {
-        fprintf(stderr, "Uso: %s <v4|v6>\n", argv[0]);
+        fprintf(stderr, "Uso: %s <v4|v6> [-c arquivo_captura] [-s shard/total]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -42,14 +782,54 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "Erro: Argumento invalido. Use 'v4' ou 'v6'.\n");
         exit(EXIT_FAILURE);
     }
+
+    const char *capture_file = NULL;
+    int shard_index = 0, shard_total = 1;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "c:s:")) != -1) {
+        switch (opt) {
+            case 'c':
+                capture_file = optarg;
+                break;
+            case 's':
+                if (shard_parse(optarg, &shard_index, &shard_total) != 0) {
+                    fprintf(stderr, "Erro: shard invalido '%s'. Use indice/total (total <= %d).\n", optarg, MAX_SHARDS);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            default:
+                fprintf(stderr, "Uso: %s <v4|v6> [-c arquivo_captura] [-s shard/total]\n", argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
     
     if (load_graph("grafo_amazonia_legal.txt", &amazonia_graph) != 0) {
         fprintf(stderr, "Failed to load graph. Exiting.\n");
         exit(EXIT_FAILURE);
     }
     
-    memset(drone_teams_status, 0, sizeof(drone_teams_status));
     memset(city_mission_active, 0, sizeof(city_mission_active));
+    memset(loans, 0, sizeof(loans));
+    route_cache_init(&route_cache);
+
+    if (shard_init(&shard, &amazonia_graph, shard_index, shard_total, ai_family) != 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    // equipes de outros shards nunca sao despachadas localmente sem emprestimo
+    team_index_init(&drone_teams, &amazonia_graph);
+    int owned_nodes[MAX_NODES];
+    for (int i = 0; i < amazonia_graph.num_nodes; i++) {
+        owned_nodes[i] = shard_owns(&shard, i);
+        if (amazonia_graph.nodes[i].type == 1 && !owned_nodes[i]) {
+            team_set_free(&drone_teams, i, 0);
+        }
+    }
+    team_region(&drone_teams, owned_nodes, &owned_teams);
+
+    char port[8];
+    shard_port(shard_index, port, sizeof(port));
 
     struct addrinfo hints, *res;
     memset(&hints, 0, sizeof(hints));
@@ -57,12 +837,12 @@ int main(int argc, char *argv[]) {
     hints.ai_socktype = SOCK_DGRAM; 
     hints.ai_flags = AI_PASSIVE;    
 
-    if (getaddrinfo(NULL, PORT, &hints, &res) != 0) {
+    if (getaddrinfo(NULL, port, &hints, &res) != 0) {
         perror("getaddrinfo");
         exit(EXIT_FAILURE);
     }
 
-    int sockfd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    sockfd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
     if (sockfd < 0) {
         perror("socket");
         exit(EXIT_FAILURE);
@@ -80,130 +860,81 @@ int main(int argc, char *argv[]) {
     }
 
     freeaddrinfo(res);
-    printf("Servidor escutando na porta %s (Modo: %s)...\n", PORT, argv[1]);
+    printf("Servidor escutando na porta %s (Modo: %s)...\n", port, argv[1]);
 
-    
-    char buffer[BUF_SIZE];
-    struct sockaddr_storage client_addr;
-    socklen_t addr_len = sizeof(client_addr);
-
-    while (1) {
-        ssize_t received_bytes = recvfrom(sockfd, buffer, BUF_SIZE, 0, 
-                                          (struct sockaddr *)&client_addr, &addr_len);
-        
-        if (received_bytes < (ssize_t)sizeof(header_t)) continue; 
-
-        header_t *header = (header_t *)buffer;
-        uint16_t msg_type = ntohs(header->type);
-        uint16_t msg_len = ntohs(header->length);
-
-        if (received_bytes < (ssize_t)(sizeof(header_t) + msg_len)) {
-            printf("Warning: Packet truncated.\n");
-            continue;
-        }
-
-        switch (msg_type) {
-            case MSG_TELEMETRIA: {
-                printf("\n[TELEMETRIA RECEBIDA]\n");
-                payload_telemetria_t *telemetria = (payload_telemetria_t *)(buffer + sizeof(header_t));
-                
-                
-                send_ack(sockfd, (struct sockaddr *)&client_addr, addr_len, ACK_TELEMETRIA);
-
-                
-                int total_cities = ntohl(telemetria->total); 
-                
-                printf("Total de cidades monitoradas: %d\n", total_cities);
-
-                for (int i = 0; i < total_cities && i < MAX_CITIES; i++) {
-                    int city_id = ntohl(telemetria->dados[i].id_cidade);
-                    int city_status = ntohl(telemetria->dados[i].status);
-
-                    if (city_status == 1) {
-                        printf("ALERTA: %s (ID=%d)\n", amazonia_graph.nodes[city_id].name, city_id);
-                        
-                        
-                        if (city_mission_active[city_id] == 1) {
-                            printf(" -> Já existe equipe atuando em %s. Alerta ignorado.\n", amazonia_graph.nodes[city_id].name);
-                            continue;
-                        }
-
-                        
-                        int dist = -1;
-                        int best_team = find_nearest_drone(&amazonia_graph, city_id, drone_teams_status, &dist);
-
-                        if (best_team != -1) {
-                            printf("\n[DESPACHANDO DRONES]\n");
-                            printf("Cidade em alerta: %s (ID=%d)\n", amazonia_graph.nodes[city_id].name, city_id);
-                            printf("> Dijkstra: Capital %s (ID=%d) selecionada, distancia = %d km\n", 
-                                   amazonia_graph.nodes[best_team].name, best_team, dist);
-                            
-                            
-                            drone_teams_status[best_team] = 1;
-                            city_mission_active[city_id] = 1;
-
-                            
-                            header_t resp_header;
-                            payload_equipe_drone_t resp_payload;
-
-                            resp_header.type = htons(MSG_EQUIPE_DRONE);
-                            resp_header.length = htons(sizeof(payload_equipe_drone_t));
-                            
-                            resp_payload.id_cidade = htonl(city_id);
-                            resp_payload.id_equipe = htonl(best_team);
-
-                            char resp_buf[sizeof(header_t) + sizeof(payload_equipe_drone_t)];
-                            memcpy(resp_buf, &resp_header, sizeof(header_t));
-                            memcpy(resp_buf + sizeof(header_t), &resp_payload, sizeof(payload_equipe_drone_t));
-
-                            sendto(sockfd, resp_buf, sizeof(resp_buf), 0, (struct sockaddr *)&client_addr, addr_len);
-                            printf("> Ordem enviada: Equipe %s (ID=%d) -> Cidade %s (ID=%d)\n",
-                                   amazonia_graph.nodes[best_team].name, best_team, 
-                                   amazonia_graph.nodes[city_id].name, city_id);
-                        } else {
-                            printf("ALERTA CRÍTICO: Nenhuma equipe de drones disponível para %s!\n", 
-                                   amazonia_graph.nodes[city_id].name);
-                        }
-                    }
-                }
-                break;
+    if (shard.total > 1) {
+        printf("Shard %d de %d. Capitais proprias:", shard.index, shard.total);
+        for (int i = 0; i < amazonia_graph.num_nodes; i++) {
+            if (amazonia_graph.nodes[i].type == 1 && shard_owns(&shard, i)) {
+                printf(" %s", amazonia_graph.nodes[i].name);
             }
+        }
+        printf("\n");
 
-            case MSG_ACK: {
-                payload_ack_t *ack = (payload_ack_t *)(buffer + sizeof(header_t));
-                int status = ntohl(ack->status);
-                printf("\n[ACK RECEBIDO] Status: %d\n", status);
-                if (status == ACK_EQUIPE_DRONE) {
-                    printf("Cliente confirmou recebimento de ordem de drone.\n");
-                }
-                break;
-            }
+        // acorda periodicamente para expirar pedidos de emprestimo sem resposta
+        struct timeval tv = { 0, LOAN_TIMEOUT_MS * 1000 / 2 };
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
 
-            case MSG_CONCLUSAO: {
-                payload_conclusao_t *conclusao = (payload_conclusao_t *)(buffer + sizeof(header_t));
-                
-                int city_id = ntohl(conclusao->id_cidade);
-                int team_id = ntohl(conclusao->id_equipe);
+    if (capture_file) {
+        if (capture_open(&capture, capture_file) != 0) {
+            exit(EXIT_FAILURE);
+        }
+        capture_enabled = 1;
+        printf("Gravando datagramas em %s\n", capture_file);
+    }
 
-                printf("\n[MISSAO CONCLUIDA]\n");
-                printf("Cidade atendida: %s (ID=%d)\n", amazonia_graph.nodes[city_id].name, city_id);
-                printf("Equipe: %s (ID=%d)\n", amazonia_graph.nodes[team_id].name, team_id);
-                
-                
-                drone_teams_status[team_id] = 0;
-                city_mission_active[city_id] = 0;
+    mcast_fd = open_status_channel(ai_family);
 
-                printf("Equipe %s liberada para novas missoes\n", amazonia_graph.nodes[team_id].name);
+    // sem SA_RESTART: o recvfrom e interrompido e o laco encerra limpando a captura
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_sigint;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
 
-                send_ack(sockfd, (struct sockaddr *)&client_addr, addr_len, ACK_CONCLUSAO);
-                break;
+    // kill -USR1 <pid> ==> imprime a ocupacao do pool
+    struct sigaction sa_usr;
+    memset(&sa_usr, 0, sizeof(sa_usr));
+    sa_usr.sa_handler = handle_sigusr1;
+    sigaction(SIGUSR1, &sa_usr, NULL);
+
+    pool_init(&pool);
+    begin_batch();
+    publish_team_status();
+    flush_tx();
+
+    while (running) {
+        begin_batch();
+        if (shard.total > 1) expire_loans();
+
+        int *rx_handles = arena_alloc(&batch_arena, POOL_BATCH_MAX * sizeof(int));
+        int rx_count = receive_batch(rx_handles);
+
+        for (int i = 0; i < rx_count; i++) {
+            if (!handle_packet(rx_handles[i])) {
+                pool_release(&pool, rx_handles[i]);
             }
+        }
 
-            default:
-                printf("Mensagem desconhecida recebida: %d\n", msg_type);
+        // um unico status multicast por lote, com o estado final
+        if (status_dirty) publish_team_status();
+        flush_tx();
+
+        if (report_pool) {
+            report_pool = 0;
+            print_pool_stats();
         }
     }
 
+    print_pool_stats();
+
+    if (capture_enabled) {
+        printf("\nCaptura encerrada: %lu registros gravados\n", capture.records);
+        capture_close(&capture);
+    }
+
+    if (mcast_fd >= 0) close(mcast_fd);
     close(sockfd);
     return 0;
 }
\ No newline at end of file
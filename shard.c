@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include "shard.h"
+
+int shard_parse(const char *spec, int *index, int *total) {
+    if (sscanf(spec, "%d/%d", index, total) != 2) return -1;
+    if (*total < 1 || *total > MAX_SHARDS || *index < 0 || *index >= *total) return -1;
+    return 0;
+}
+
+void shard_port(int index, char *out, size_t size) {
+    snprintf(out, size, "%d", atoi(PORT) + index);
+}
+
+// Encadeia as capitais por vizinhanca: parte de uma extremidade do mapa (a capital
+// com a vizinha mais distante) e segue sempre para a capital mais proxima ainda
+// nao visitada. A cadeia e cortada em 'total' blocos contiguos de tamanho
+// equilibrado, entao cada shard fica com um grupo de capitais vizinhas.
+static void group_capitals(const Graph *g, int total, int *capital_shard) {
+    static RouteCache cache;
+    route_cache_init(&cache);
+
+    int capitals[MAX_NODES];
+    int count = 0;
+    for (int i = 0; i < g->num_nodes; i++) {
+        capital_shard[i] = -1;
+        if (g->nodes[i].type == 1) capitals[count++] = i;
+    }
+    if (count == 0) return;
+
+    int start = capitals[0];
+    int start_ecc = -1;
+    for (int a = 0; a < count; a++) {
+        const ShortestPathTree *tree = route_cache_get(&cache, g, capitals[a]);
+        int ecc = 0;
+        for (int b = 0; b < count; b++) {
+            if (tree->dist[capitals[b]] > ecc) ecc = tree->dist[capitals[b]];
+        }
+        if (ecc > start_ecc) {
+            start_ecc = ecc;
+            start = capitals[a];
+        }
+    }
+
+    int visited[MAX_NODES] = {0};
+    int current = start;
+    for (int pos = 0; pos < count; pos++) {
+        visited[current] = 1;
+        capital_shard[current] = pos * total / count;
+
+        const ShortestPathTree *tree = route_cache_get(&cache, g, current);
+        int next = -1;
+        for (int b = 0; b < count; b++) {
+            int c = capitals[b];
+            if (!visited[c] && (next == -1 || tree->dist[c] < tree->dist[next])) next = c;
+        }
+        current = next;
+    }
+}
+
+int shard_init(ShardConfig *cfg, const Graph *g, int index, int total, int ai_family) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->index = index;
+    cfg->total = total;
+
+    // cada cidade segue o shard da capital da sua regiao
+    int capital_shard[MAX_NODES];
+    group_capitals(g, total, capital_shard);
+
+    compute_regions(g, cfg->region);
+    for (int i = 0; i < g->num_nodes; i++) {
+        cfg->owner[i] = (cfg->region[i] >= 0) ? capital_shard[cfg->region[i]] : 0;
+    }
+
+    const char *host = (ai_family == AF_INET6) ? "::1" : "127.0.0.1";
+    for (int k = 0; k < total; k++) {
+        struct addrinfo hints, *res;
+        char port[8];
+
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = ai_family;
+        hints.ai_socktype = SOCK_DGRAM;
+        shard_port(k, port, sizeof(port));
+
+        if (getaddrinfo(host, port, &hints, &res) != 0) {
+            fprintf(stderr, "Erro ao resolver shard %d (%s:%s)\n", k, host, port);
+            return -1;
+        }
+        memcpy(&cfg->peers[k], res->ai_addr, res->ai_addrlen);
+        cfg->peer_len[k] = res->ai_addrlen;
+        freeaddrinfo(res);
+    }
+    return 0;
+}
+
+int shard_owns(const ShardConfig *cfg, int node) {
+    return cfg->owner[node] == cfg->index;
+}
+
+int shard_peer_index(const ShardConfig *cfg, const struct sockaddr *addr) {
+    for (int k = 0; k < cfg->total; k++) {
+        if (k == cfg->index) continue;
+
+        const struct sockaddr *peer = (const struct sockaddr *)&cfg->peers[k];
+        if (peer->sa_family != addr->sa_family) continue;
+
+        if (addr->sa_family == AF_INET) {
+            const struct sockaddr_in *a = (const struct sockaddr_in *)addr;
+            const struct sockaddr_in *b = (const struct sockaddr_in *)peer;
+            if (a->sin_port == b->sin_port && a->sin_addr.s_addr == b->sin_addr.s_addr) return k;
+        } else if (addr->sa_family == AF_INET6) {
+            const struct sockaddr_in6 *a = (const struct sockaddr_in6 *)addr;
+            const struct sockaddr_in6 *b = (const struct sockaddr_in6 *)peer;
+            if (a->sin6_port == b->sin6_port &&
+                memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(a->sin6_addr)) == 0) return k;
+        }
+    }
+    return -1;
+}
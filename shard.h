@@ -0,0 +1,53 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include "common.h"
+#include "graph.h"
+
+#define SHARD_FAR_KM 1500      // equipe local mais distante que isso ==> pede emprestimo
+#define LOAN_TIMEOUT_MS 500    // espera pela resposta de cada shard vizinho
+#define LEND_HOLD_MS (4 * LOAN_TIMEOUT_MS) // equipe cedida sem confirmacao volta a ficar livre
+#define MAX_PENDING_LOANS MAX_NODES
+
+typedef struct {
+    int index;
+    int total;
+    int region[MAX_NODES]; // capital mais proxima de cada cidade
+    int owner[MAX_NODES];  // shard dono de cada cidade (o da capital da sua regiao)
+    struct sockaddr_storage peers[MAX_SHARDS];
+    socklen_t peer_len[MAX_SHARDS];
+} ShardConfig;
+
+typedef struct {
+    int active;
+    int id_pedido;
+    int city_id;
+    int local_team; // melhor equipe propria (-1 se nenhuma), usada se todos recusarem
+    int local_dist;
+    int peer;
+    int tried;
+    struct timeval deadline;
+    struct sockaddr_storage client_addr;
+    socklen_t client_len;
+} Loan;
+
+// Equipe cedida a outro shard, aguardando a confirmacao de que foi aceita.
+typedef struct {
+    int active;
+    int id_pedido;
+    int peer;
+    int team;
+    struct timeval deadline;
+} Lend;
+
+// "i/n" ==> shard i de n. Retorna -1 se invalido.
+int shard_parse(const char *spec, int *index, int *total);
+int shard_init(ShardConfig *cfg, const Graph *g, int index, int total, int ai_family);
+void shard_port(int index, char *out, size_t size);
+int shard_owns(const ShardConfig *cfg, int node);
+// Indice do shard que enviou 'addr', ou -1 se nao for um shard vizinho.
+int shard_peer_index(const ShardConfig *cfg, const struct sockaddr *addr);
+
+#endif // SHARD_H
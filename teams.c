@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <string.h>
+#include "teams.h"
+
+void bitset_clear_all(Bitset *b) {
+    memset(b->w, 0, sizeof(b->w));
+}
+
+void bitset_set(Bitset *b, int bit) {
+    b->w[bit / 64] |= (uint64_t)1 << (bit % 64);
+}
+
+void bitset_clear(Bitset *b, int bit) {
+    b->w[bit / 64] &= ~((uint64_t)1 << (bit % 64));
+}
+
+int bitset_test(const Bitset *b, int bit) {
+    return (b->w[bit / 64] >> (bit % 64)) & 1;
+}
+
+int bitset_count(const Bitset *b) {
+    int total = 0;
+    for (int i = 0; i < BITSET_WORDS; i++) {
+        total += __builtin_popcountll(b->w[i]);
+    }
+    return total;
+}
+
+void team_index_init(TeamIndex *teams, const Graph *g) {
+    teams->count = 0;
+    bitset_clear_all(&teams->free);
+
+    for (int i = 0; i < MAX_NODES; i++) {
+        teams->index[i] = -1;
+    }
+
+    for (int i = 0; i < g->num_nodes; i++) {
+        if (g->nodes[i].type == 1) {
+            teams->node[teams->count] = i;
+            teams->index[i] = teams->count;
+            bitset_set(&teams->free, teams->count);
+            teams->count++;
+        }
+    }
+
+    teams->order_version = -1;
+}
+
+void team_set_free(TeamIndex *teams, int node, int is_free) {
+    int idx = teams->index[node];
+    if (idx < 0) return;
+
+    if (is_free) {
+        bitset_set(&teams->free, idx);
+    } else {
+        bitset_clear(&teams->free, idx);
+    }
+}
+
+int team_is_free(const TeamIndex *teams, int node) {
+    int idx = teams->index[node];
+    return idx >= 0 && bitset_test(&teams->free, idx);
+}
+
+int team_any_free(const TeamIndex *teams) {
+    for (int i = 0; i < BITSET_WORDS; i++) {
+        if (teams->free.w[i]) return 1;
+    }
+    return 0;
+}
+
+void team_region(const TeamIndex *teams, const int *in_region, Bitset *out) {
+    bitset_clear_all(out);
+    for (int k = 0; k < teams->count; k++) {
+        if (in_region[teams->node[k]]) bitset_set(out, k);
+    }
+}
+
+int team_count_free_in(const TeamIndex *teams, const Bitset *region) {
+    int total = 0;
+    for (int i = 0; i < BITSET_WORDS; i++) {
+        total += __builtin_popcountll(teams->free.w[i] & region->w[i]);
+    }
+    return total;
+}
+
+// Ordena, para cada cidade, as capitais por (distancia, ID) usando as arvores em cache.
+// Grafo nao direcionado: a distancia capital -> cidade e a mesma da cidade -> capital.
+static void build_candidate_order(TeamIndex *teams, RouteCache *cache, const Graph *g) {
+    for (int city = 0; city < g->num_nodes; city++) {
+        int *order = teams->order[city];
+        int *order_dist = teams->order_dist[city];
+
+        for (int k = 0; k < teams->count; k++) {
+            const ShortestPathTree *tree = route_cache_get(cache, g, teams->node[k]);
+            int dist = tree->dist[city];
+
+            // insercao estavel: empate mantem a capital de menor ID na frente
+            int pos = k;
+            while (pos > 0 && order_dist[pos - 1] > dist) {
+                order[pos] = order[pos - 1];
+                order_dist[pos] = order_dist[pos - 1];
+                pos--;
+            }
+            order[pos] = k;
+            order_dist[pos] = dist;
+        }
+    }
+    teams->order_version = g->version;
+}
+
+int team_nearest_free(TeamIndex *teams, RouteCache *cache, const Graph *g, int city, int *distance_out) {
+    if (teams->order_version != g->version) {
+        build_candidate_order(teams, cache, g);
+    }
+
+    int best_node = -1;
+    int min_dist = INF;
+
+    if (team_any_free(teams)) {
+        for (int k = 0; k < teams->count; k++) {
+            if (teams->order_dist[city][k] >= INF) break;
+
+            int idx = teams->order[city][k];
+            if (bitset_test(&teams->free, idx)) {
+                best_node = teams->node[idx];
+                min_dist = teams->order_dist[city][k];
+                break;
+            }
+        }
+    }
+
+    if (distance_out) *distance_out = min_dist;
+    return best_node;
+}
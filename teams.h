@@ -0,0 +1,43 @@
+#ifndef TEAMS_H
+#define TEAMS_H
+
+#include <stdint.h>
+#include "graph.h"
+
+#define BITSET_WORDS ((MAX_NODES + 63) / 64)
+
+typedef struct {
+    uint64_t w[BITSET_WORDS];
+} Bitset;
+
+// Capitais numeradas de forma compacta (0..count-1); a disponibilidade das
+// equipes e um bit por capital. Para cada cidade, as capitais ficam ordenadas
+// pela distancia, de modo que o despacho para na primeira equipe livre.
+typedef struct {
+    int count;
+    int node[MAX_NODES];  // indice compacto -> no do grafo
+    int index[MAX_NODES]; // no do grafo -> indice compacto (-1 se nao for capital)
+    Bitset free;
+    int order[MAX_NODES][MAX_NODES];      // por cidade: indices compactos por distancia crescente
+    int order_dist[MAX_NODES][MAX_NODES];
+    int order_version;
+} TeamIndex;
+
+void bitset_clear_all(Bitset *b);
+void bitset_set(Bitset *b, int bit);
+void bitset_clear(Bitset *b, int bit);
+int bitset_test(const Bitset *b, int bit);
+int bitset_count(const Bitset *b);
+
+// Todas as equipes comecam livres.
+void team_index_init(TeamIndex *teams, const Graph *g);
+void team_set_free(TeamIndex *teams, int node, int is_free);
+int team_is_free(const TeamIndex *teams, int node);
+int team_any_free(const TeamIndex *teams);
+// Bitset das capitais cujo no esta marcado em in_region[] (indexado por no do grafo).
+void team_region(const TeamIndex *teams, const int *in_region, Bitset *out);
+int team_count_free_in(const TeamIndex *teams, const Bitset *region);
+// Equipe livre mais proxima de 'city' (empate ==> capital de menor ID), ou -1.
+int team_nearest_free(TeamIndex *teams, RouteCache *cache, const Graph *g, int city, int *distance_out);
+
+#endif // TEAMS_H